@@ -66,6 +66,18 @@ bool HackPhis();
 // Returns true if basic blocks should be in "structured" order.
 bool HackBlockOrder();
 
+// The driver code is generated for.  Each driver enables the -hack-*
+// workarounds it needs, in addition to those enabled explicitly.
+enum class TargetDriver {
+  // A driver needing no workaround.
+  Generic,
+  // A driver needing every workaround for driver bugs.
+  Legacy
+};
+
+// Returns the driver code is generated for.
+TargetDriver Driver();
+
 // Returns true if module-scope constants are to be collected into a single
 // storage buffer.  The binding for that buffer, and its intialization data
 // are given in the descriptor map file.
@@ -123,6 +135,10 @@ bool Int8Support();
 // Returns true if clspv should lower long-vector types and instructions.
 bool LongVectorSupport();
 
+// Returns true if long vectors are lowered to 4-element vectors instead of
+// scalars.
+bool LongVectorChunks();
+
 // Returns true when images are supported.
 bool ImageSupport();
 
@@ -204,6 +220,55 @@ bool ArmNonUniformWorkGroupSize();
 // Returns true if uniform_workgroup_size is enabled
 bool UniformWorkgroupSize();
 
+// Returns true if the generated SPIR-V should be optimized for size.
+bool OptimizeSPIRVSize();
+
+// Returns true if generated functions should be streamed out as soon as they
+// are complete instead of being held in memory until the end.
+bool StreamFunctions();
+
+// Returns true if source line information should be emitted.
+bool DebugInfo();
+
+// Returns true if component accesses to buffers should be merged into vector
+// accesses.
+bool VectorizeStorageBufferAccesses();
+
+// Returns true if atomic additions to subgroup uniform addresses should be
+// performed once per subgroup.
+bool AggregateSubgroupAtomics();
+
+// Returns true if float atomic operations can be used.
+bool FloatAtomics();
+
+// Returns true if 64-bit integer atomic operations are enabled.
+bool Int64Atomics();
+
+// Returns true if global pointer kernel arguments are passed as physical
+// storage buffer addresses.
+bool PhysicalStorageBuffers();
+
+// Returns true if code is generated for the Vulkan memory model.
+bool VulkanMemoryModel();
+
+// Returns true if barriers and fences are narrowed to the memory they order.
+bool NarrowBarriers();
+
+// Returns true if 64-bit integer arithmetic is narrowed to 32 bits where the
+// result is unchanged.
+bool NarrowInt64();
+
+// Returns true if work-item builtins are computed once per function.
+bool SpecializeWorkItemBuiltins();
+
+// Returns the maximum number of elements of the private arrays promoted to
+// registers. 0 means no array is promoted.
+uint32_t MaxPromotedPrivateArraySize();
+
+// Returns true if __local variables used by the same kernel are shared when a
+// work-group barrier separates their uses.
+bool ShareLocalsAcrossBarriers();
+
 } // namespace Option
 } // namespace clspv
 
@@ -153,10 +153,12 @@ llvm::ModulePass *createReplaceOpenCLBuiltinPass();
 
 /// Create a pass to emit SPIR-V for the module.
 /// @return An LLVM module pass.
+///
+/// The pass always writes a SPIR-V binary to |out|. Other output formats are
+/// derived from that binary by the caller.
 llvm::ModulePass *createSPIRVProducerPass(
     llvm::raw_pwrite_stream *out,
-    llvm::SmallVectorImpl<std::pair<unsigned, std::string>> *samplerMap,
-    bool outputCInitList);
+    llvm::SmallVectorImpl<std::pair<unsigned, std::string>> *samplerMap);
 llvm::ModulePass *createSPIRVProducerPass();
 
 /// Undo LLVM's bitcast instructions with pointer type.
@@ -419,4 +421,39 @@ llvm::ModulePass *createAutoPodArgsPass();
 /// provide faster, lower precision alternatives.
 llvm::ModulePass *createNativeMathPass();
 
+/// Vectorize storage buffer accesses.
+/// @return An LLVM module pass.
+///
+/// Merges loads (or complete sets of stores) of the individual components of
+/// a vector element of a resource variable within a basic block into a single
+/// vector access.
+llvm::ModulePass *createVectorizeStorageBufferAccessesPass();
+
+/// Replaces integer atomic additions to a sub-group uniform address by a single
+/// atomic per sub-group. Each invocation's result is recovered from the
+/// sub-group's result and an exclusive scan of the added values.
+llvm::ModulePass *createAggregateSubgroupAtomicsPass();
+
+/// Replaces compare-exchange loops implementing a floating-point atomic
+/// addition by a native floating-point atomic addition.
+llvm::ModulePass *createReplaceFloatAtomicLoopsPass();
+
+/// Replaces the global pointer parameters of kernels by 64-bit device
+/// addresses, which are converted back to pointers at the top of the kernel.
+llvm::ModulePass *createPhysicalPointerArgsPass();
+
+/// Removes the memory semantics of barriers and fences for the address spaces
+/// not accessed on both sides of them, removes the barriers and fences left
+/// ordering nothing and merges adjacent ones.
+llvm::ModulePass *createNarrowBarriersPass();
+
+/// Rewrites 64-bit integer expressions used as 32-bit indices, truncated to 32
+/// bits or compared after extension from 32 bits with 32-bit arithmetic.
+llvm::ModulePass *createNarrowInt64Pass();
+
+/// Splits small private arrays into one variable per element so they can be
+/// promoted to registers. Dynamically indexed accesses select among the
+/// elements.
+llvm::ModulePass *createPromotePrivateArraysPass();
+
 } // namespace clspv
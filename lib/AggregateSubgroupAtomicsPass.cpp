@@ -0,0 +1,268 @@
+// Copyright 2021 The Clspv Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/Transforms/Utils/BasicBlockUtils.h"
+
+#include "spirv/unified1/spirv.hpp"
+
+#include "Builtins.h"
+#include "Passes.h"
+#include "SPIRVOp.h"
+
+using namespace llvm;
+
+#define DEBUG_TYPE "aggregatesubgroupatomics"
+
+namespace {
+struct AggregateSubgroupAtomicsPass : public ModulePass {
+  static char ID;
+  AggregateSubgroupAtomicsPass() : ModulePass(ID) {}
+
+  bool runOnModule(Module &M) override;
+
+private:
+  // An atomic addition that can be aggregated.
+  struct Candidate {
+    Instruction *atomic;
+    Value *pointer;
+    // The value added by this invocation.
+    Value *value;
+    // The memory scope and semantics of the atomic, or nullptr for an
+    // atomicrmw.
+    Value *scope;
+    Value *semantics;
+  };
+
+  // Returns true if |V| has the same value in every invocation of the
+  // sub-group.
+  bool IsSubgroupUniform(Value *V);
+
+  // Returns true and fills |candidate| if |I| is an atomic addition that may
+  // be aggregated.
+  bool IsCandidate(Instruction *I, Candidate *candidate);
+
+  void Aggregate(const Candidate &candidate);
+
+  // Returns the declaration of the sub-group builtin |name| applied to values
+  // of type |Ty| (none if |Ty| is nullptr).
+  FunctionCallee GetSubgroupBuiltin(Module &M, const std::string &name,
+                                    Type *RetTy, Type *Ty);
+
+  DenseMap<Value *, bool> uniform_;
+};
+} // namespace
+
+char AggregateSubgroupAtomicsPass::ID = 0;
+INITIALIZE_PASS(AggregateSubgroupAtomicsPass, "AggregateSubgroupAtomics",
+                "Aggregate Subgroup Atomics Pass", false, false)
+
+namespace clspv {
+ModulePass *createAggregateSubgroupAtomicsPass() {
+  return new AggregateSubgroupAtomicsPass();
+}
+} // namespace clspv
+
+bool AggregateSubgroupAtomicsPass::IsSubgroupUniform(Value *V) {
+  if (isa<Constant>(V))
+    return true;
+
+  if (auto *arg = dyn_cast<Argument>(V)) {
+    // Kernel arguments are the same for the whole dispatch. The arguments of
+    // other functions depend on their call sites.
+    return arg->getParent()->getCallingConv() == CallingConv::SPIR_KERNEL;
+  }
+
+  auto *I = dyn_cast<Instruction>(V);
+  if (!I)
+    return false;
+
+  auto iter = uniform_.find(I);
+  if (iter != uniform_.end())
+    return iter->second;
+
+  // Assume the value varies while its operands are visited so that cycles
+  // through phis do not recurse.
+  uniform_[I] = false;
+
+  // Only pure computations of uniform operands are uniform. Phis, loads and
+  // calls may differ between invocations.
+  bool uniform = false;
+  if (isa<GetElementPtrInst>(I) || isa<CastInst>(I) ||
+      isa<BinaryOperator>(I) || isa<CmpInst>(I) || isa<SelectInst>(I)) {
+    uniform = true;
+    for (auto &op : I->operands()) {
+      if (!IsSubgroupUniform(op.get())) {
+        uniform = false;
+        break;
+      }
+    }
+  }
+
+  uniform_[I] = uniform;
+  return uniform;
+}
+
+bool AggregateSubgroupAtomicsPass::IsCandidate(Instruction *I,
+                                               Candidate *candidate) {
+  candidate->atomic = I;
+  candidate->scope = nullptr;
+  candidate->semantics = nullptr;
+
+  if (auto *rmw = dyn_cast<AtomicRMWInst>(I)) {
+    // atomic_add and atom_add. They do not order other memory accesses.
+    if (rmw->getOperation() != AtomicRMWInst::Add || rmw->isVolatile())
+      return false;
+    candidate->pointer = rmw->getPointerOperand();
+    candidate->value = rmw->getValOperand();
+  } else if (auto *call = dyn_cast<CallInst>(I)) {
+    auto *callee = call->getCalledFunction();
+    if (!callee || clspv::Builtins::Lookup(callee).getType() !=
+                       clspv::Builtins::kSpirvOp)
+      return false;
+    auto opcode =
+        cast<ConstantInt>(call->getArgOperand(0))->getZExtValue();
+    if (opcode == spv::OpAtomicIIncrement) {
+      // atomic_inc and atom_inc. They do not order other memory accesses.
+      candidate->value = ConstantInt::get(call->getType(), 1);
+    } else if (opcode == spv::OpAtomicIAdd) {
+      // The atomic_fetch_add family. Only the elected invocation performs the
+      // atomic, so it must not order the accesses of the other invocations.
+      auto *semantics = dyn_cast<ConstantInt>(call->getArgOperand(3));
+      const uint64_t ordering_mask =
+          spv::MemorySemanticsAcquireMask | spv::MemorySemanticsReleaseMask |
+          spv::MemorySemanticsAcquireReleaseMask |
+          spv::MemorySemanticsSequentiallyConsistentMask;
+      if (!semantics || (semantics->getZExtValue() & ordering_mask))
+        return false;
+      candidate->value = call->getArgOperand(4);
+    } else {
+      return false;
+    }
+    candidate->pointer = call->getArgOperand(1);
+    candidate->scope = call->getArgOperand(2);
+    candidate->semantics = call->getArgOperand(3);
+  } else {
+    return false;
+  }
+
+  auto *Ty = candidate->value->getType();
+  if (!Ty->isIntegerTy(32) && !Ty->isIntegerTy(64))
+    return false;
+
+  return IsSubgroupUniform(candidate->pointer);
+}
+
+FunctionCallee AggregateSubgroupAtomicsPass::GetSubgroupBuiltin(
+    Module &M, const std::string &name, Type *RetTy, Type *Ty) {
+  std::string mangled = "_Z" + std::to_string(name.size()) + name;
+  SmallVector<Type *, 1> params;
+  if (Ty) {
+    mangled += Ty->isIntegerTy(64) ? "m" : "j";
+    params.push_back(Ty);
+  } else {
+    mangled += "v";
+  }
+  auto callee =
+      M.getOrInsertFunction(mangled, FunctionType::get(RetTy, params, false));
+  cast<Function>(callee.getCallee())->addFnAttr(Attribute::Convergent);
+  return callee;
+}
+
+void AggregateSubgroupAtomicsPass::Aggregate(const Candidate &candidate) {
+  //
+  // Original IR
+  // 1. old = atomic add ptr, v
+  //
+  // Transformed IR
+  // 1. total = sub_group_reduce_add(v)
+  // 2. offset = sub_group_scan_exclusive_add(v)
+  // 3. if (sub_group_elect())
+  // 4.   elected_old = atomic add ptr, total
+  // 5. base = sub_group_broadcast_first(phi(elected_old, undef))
+  // 6. old = base + offset
+  //
+  // The elected invocation is the lowest active one, which is the one
+  // sub_group_broadcast_first reads from. The scan and broadcast are only
+  // needed if the result of the atomic is used.
+  //
+  auto *atomic = candidate.atomic;
+  auto &M = *atomic->getModule();
+  auto *Ty = candidate.value->getType();
+  bool result_used = !atomic->use_empty();
+
+  IRBuilder<> Builder(atomic);
+  auto *total = Builder.CreateCall(
+      GetSubgroupBuiltin(M, "sub_group_reduce_add", Ty, Ty), {candidate.value});
+  Value *offset = nullptr;
+  if (result_used) {
+    offset = Builder.CreateCall(
+        GetSubgroupBuiltin(M, "sub_group_scan_exclusive_add", Ty, Ty),
+        {candidate.value});
+  }
+  auto *elect = Builder.CreateCall(
+      GetSubgroupBuiltin(M, "sub_group_elect", Builder.getInt32Ty(), nullptr));
+  auto *is_elected = Builder.CreateICmpNE(elect, Builder.getInt32(0));
+
+  auto *then_term = SplitBlockAndInsertIfThen(is_elected, atomic, false);
+  Instruction *elected_atomic = nullptr;
+  if (candidate.scope) {
+    elected_atomic = clspv::InsertSPIRVOp(
+        then_term, spv::OpAtomicIAdd, {Attribute::Convergent}, Ty,
+        {candidate.pointer, candidate.scope, candidate.semantics, total});
+  } else {
+    auto *rmw = cast<AtomicRMWInst>(atomic);
+    elected_atomic = new AtomicRMWInst(
+        AtomicRMWInst::Add, candidate.pointer, total, rmw->getAlign(),
+        rmw->getOrdering(), rmw->getSyncScopeID(), then_term);
+  }
+
+  if (result_used) {
+    Builder.SetInsertPoint(atomic);
+    auto *phi = Builder.CreatePHI(Ty, 2);
+    phi->addIncoming(elected_atomic, then_term->getParent());
+    phi->addIncoming(UndefValue::get(Ty),
+                     then_term->getParent()->getSinglePredecessor());
+    auto *base = Builder.CreateCall(
+        GetSubgroupBuiltin(M, "sub_group_broadcast_first", Ty, Ty), {phi});
+    atomic->replaceAllUsesWith(Builder.CreateAdd(base, offset));
+  }
+  atomic->eraseFromParent();
+}
+
+bool AggregateSubgroupAtomicsPass::runOnModule(Module &M) {
+  SmallVector<Candidate, 8> candidates;
+  for (auto &F : M) {
+    for (auto &BB : F) {
+      for (auto &I : BB) {
+        Candidate candidate;
+        if (IsCandidate(&I, &candidate)) {
+          candidates.push_back(candidate);
+        }
+      }
+    }
+  }
+  uniform_.clear();
+
+  for (auto &candidate : candidates) {
+    Aggregate(candidate);
+  }
+
+  return !candidates.empty();
+}
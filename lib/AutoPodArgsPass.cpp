@@ -179,12 +179,15 @@ void AutoPodArgsPass::runOnFunction(Function &F) {
   // 2. Global type mangled push constant interface.
   // 3. UBO
   // 4. SSBO
+  //
+  // Physical storage buffers share the global address space with storage
+  // buffers, so pod args are never placed in a storage buffer in that mode.
   clspv::PodArgImpl impl = clspv::PodArgImpl::kSSBO;
   if (satisfies_push_constant) {
     impl = clspv::PodArgImpl::kPushConstant;
   } else if (satisfies_global_push_constant) {
     impl = clspv::PodArgImpl::kGlobalPushConstant;
-  } else if (satisfies_ubo) {
+  } else if (satisfies_ubo || clspv::Option::PhysicalStorageBuffers()) {
     impl = clspv::PodArgImpl::kUBO;
   }
   AddMetadata(F, impl);
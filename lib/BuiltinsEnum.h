@@ -328,6 +328,21 @@ enum BuiltinType {
   kGetPipeMaxPackets,
   kType_Pipe_End,
 
+  kType_WorkGroup_Start,
+  kWorkGroupAll,
+  kWorkGroupAny,
+  kWorkGroupBroadcast,
+  kWorkGroupReduceAdd,
+  kWorkGroupReduceMin,
+  kWorkGroupReduceMax,
+  kWorkGroupScanExclusiveAdd,
+  kWorkGroupScanExclusiveMin,
+  kWorkGroupScanExclusiveMax,
+  kWorkGroupScanInclusiveAdd,
+  kWorkGroupScanInclusiveMin,
+  kWorkGroupScanInclusiveMax,
+  kType_WorkGroup_End,
+
   kType_SubgroupsKHR_Start,
   kGetSubGroupSize,
   kGetMaxSubGroupSize,
@@ -348,6 +363,36 @@ enum BuiltinType {
   kSubGroupScanInclusiveAdd,
   kSubGroupScanInclusiveMin,
   kSubGroupScanInclusiveMax,
+  kSubGroupElect,
+  kSubGroupShuffle,
+  kSubGroupShuffleXor,
+  kSubGroupShuffleUp,
+  kSubGroupShuffleDown,
+  kSubGroupNonUniformBroadcast,
+  kSubGroupBroadcastFirst,
+  kSubGroupBallot,
+  kSubGroupInverseBallot,
+  kSubGroupBallotBitExtract,
+  kSubGroupBallotBitCount,
+  kSubGroupBallotInclusiveScan,
+  kSubGroupBallotExclusiveScan,
+  kSubGroupBallotFindLSB,
+  kSubGroupBallotFindMSB,
+  kGetSubGroupEqMask,
+  kGetSubGroupGeMask,
+  kGetSubGroupGtMask,
+  kGetSubGroupLeMask,
+  kGetSubGroupLtMask,
+  kSubGroupNonUniformAdd,
+  kSubGroupNonUniformMul,
+  kSubGroupNonUniformMin,
+  kSubGroupNonUniformMax,
+  kSubGroupNonUniformAnd,
+  kSubGroupNonUniformOr,
+  kSubGroupNonUniformXor,
+  kSubGroupNonUniformLogicalAnd,
+  kSubGroupNonUniformLogicalOr,
+  kSubGroupNonUniformLogicalXor,
   kSubGroupReserveReadPipe,
   kSubGroupReserveWritePipe,
   kSubGroupCommitReadPipe,
@@ -36,6 +36,7 @@
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Transforms/IPO/PassManagerBuilder.h"
+#include "spirv-tools/libspirv.hpp"
 
 #include "clspv/AddressSpace.h"
 #include "clspv/Option.h"
@@ -47,6 +48,7 @@
 #include "Builtins.h"
 #include "FrontendPlugin.h"
 #include "Passes.h"
+#include "ReflectionParser.h"
 
 #include <cassert>
 #include <numeric>
@@ -148,6 +150,28 @@ static llvm::cl::opt<std::string> OutputFormat(
         "Specify special output format. 'c' is as a C initializer list"),
     llvm::cl::value_desc("format"));
 
+static llvm::cl::opt<std::string> BinaryOutputFile(
+    "spv-out",
+    llvm::cl::desc("Also write the SPIR-V binary to the given file"),
+    llvm::cl::value_desc("filename"));
+
+static llvm::cl::opt<std::string> CInitListOutputFile(
+    "spvinc-out",
+    llvm::cl::desc(
+        "Also write the SPIR-V as a C initializer list to the given file"),
+    llvm::cl::value_desc("filename"));
+
+static llvm::cl::opt<std::string> AssemblyOutputFile(
+    "spvasm-out",
+    llvm::cl::desc("Also write the SPIR-V disassembly to the given file"),
+    llvm::cl::value_desc("filename"));
+
+static llvm::cl::opt<std::string> DescriptorMapOutputFile(
+    "descriptormap-out",
+    llvm::cl::desc("Also write the descriptor map derived from the embedded "
+                   "reflection to the given file"),
+    llvm::cl::value_desc("filename"));
+
 static llvm::cl::opt<std::string>
     SamplerMap("samplermap", llvm::cl::desc("DEPRECATED - Literal sampler map"),
                llvm::cl::value_desc("filename"));
@@ -389,6 +413,10 @@ clang::TargetInfo *PrepareTargetInfo(CompilerInstance &instance) {
   if (!clspv::Option::FP64()) {
     Opts["cl_khr_fp64"] = false;
   }
+  if (!clspv::Option::Int64Atomics()) {
+    Opts["cl_khr_int64_base_atomics"] = false;
+    Opts["cl_khr_int64_extended_atomics"] = false;
+  }
 
   // Disable CL3.0 feature macros for unsupported features
   if (instance.getLangOpts().LangStd == clang::LangStandard::lang_opencl30) {
@@ -517,10 +545,12 @@ int SetCompilerInstanceOptions(CompilerInstance &instance,
   // chance to view the unoptimal code first
   instance.getCodeGenOpts().OptimizationLevel = 0;
 
-// Debug information is disabled temporarily to call instruction.
-#if 0
-  instance.getCodeGenOpts().setDebugInfo(clang::codegenoptions::FullDebugInfo);
-#endif
+  // Only line tables are requested. Full debug info introduces llvm.dbg.*
+  // intrinsic calls that the rest of the flow does not handle.
+  if (clspv::Option::DebugInfo()) {
+    instance.getCodeGenOpts().setDebugInfo(
+        clang::codegenoptions::DebugLineTablesOnly);
+  }
 
   // We use the 32-bit pointer-width SPIR triple
   llvm::Triple triple("spir-unknown-unknown");
@@ -647,6 +677,9 @@ int PopulatePassManager(
   pm->add(clspv::createNativeMathPass());
   pm->add(clspv::createZeroInitializeAllocasPass());
   pm->add(clspv::createAddFunctionAttributesPass());
+  if (clspv::Option::PhysicalStorageBuffers()) {
+    pm->add(clspv::createPhysicalPointerArgsPass());
+  }
   pm->add(clspv::createAutoPodArgsPass());
   pm->add(clspv::createDeclarePushConstantsPass());
   pm->add(clspv::createDefineOpenCLWorkItemBuiltinsPass());
@@ -669,6 +702,12 @@ int PopulatePassManager(
     pm->add(clspv::createLongVectorLoweringPass());
   }
 
+  // Split small dynamically indexed private arrays so that mem2reg promotes
+  // their elements to registers.
+  if (clspv::Option::MaxPromotedPrivateArraySize() > 0) {
+    pm->add(clspv::createPromotePrivateArraysPass());
+  }
+
   // We need to run mem2reg and inst combine early because our
   // createInlineFuncWithPointerBitCastArgPass pass cannot handle the pattern
   //   %1 = alloca i32 1
@@ -733,6 +772,18 @@ int PopulatePassManager(
 
   pm->add(clspv::createUndoInstCombinePass());
   pm->add(clspv::createFunctionInternalizerPass());
+  if (clspv::Option::FloatAtomics()) {
+    pm->add(clspv::createReplaceFloatAtomicLoopsPass());
+  }
+  if (clspv::Option::AggregateSubgroupAtomics()) {
+    pm->add(clspv::createAggregateSubgroupAtomicsPass());
+  }
+  if (clspv::Option::NarrowBarriers()) {
+    pm->add(clspv::createNarrowBarriersPass());
+  }
+  if (clspv::Option::NarrowInt64()) {
+    pm->add(clspv::createNarrowInt64Pass());
+  }
   pm->add(clspv::createReplaceLLVMIntrinsicsPass());
   // Replace LLVM intrinsics can leave dead code around.
   pm->add(llvm::createDeadCodeEliminationPass());
@@ -769,6 +820,11 @@ int PopulatePassManager(
   // Run after DRA to clean up parameters and help reduce the need for variable
   // pointers.
   pm->add(clspv::createRemoveUnusedArgumentsPass());
+  // Run after DRA so that more accesses are rooted directly at resource
+  // variables.
+  if (clspv::Option::VectorizeStorageBufferAccesses()) {
+    pm->add(clspv::createVectorizeStorageBufferAccessesPass());
+  }
 
   // SPIR-V 1.4 and higher do not need to splat scalar conditions for vector
   // data.
@@ -799,8 +855,7 @@ int PopulatePassManager(
   // This pass mucks with types to point where you shouldn't rely on DataLayout
   // anymore so leave this right before SPIR-V generation.
   pm->add(clspv::createUBOTypeTransformPass());
-  pm->add(clspv::createSPIRVProducerPass(binaryStream, SamplerMapEntries,
-                                         OutputFormat == "c"));
+  pm->add(clspv::createSPIRVProducerPass(binaryStream, SamplerMapEntries));
 
   return 0;
 }
@@ -878,6 +933,13 @@ int ParseOptions(const int argc, const char *const argv[]) {
     }
   }
 
+  if (clspv::Option::AggregateSubgroupAtomics() &&
+      clspv::Option::SpvVersion() < clspv::Option::SPIRVVersion::SPIRV_1_3) {
+    llvm::errs() << "aggregating subgroup atomics requires SPIR-V 1.3 or "
+                    "greater\n";
+    return -1;
+  }
+
   if (clspv::Option::ArmNonUniformWorkGroupSize() &&
       clspv::Option::UniformWorkgroupSize()) {
     llvm::errs() << "cannot enable Arm non-uniform workgroup extension support "
@@ -903,6 +965,89 @@ int GenerateIRFile(llvm::legacy::PassManager *pm, llvm::Module &module,
   return 0;
 }
 
+// The formats in which the compiled binary can be written.
+enum class OutputKind { Binary, CInitList, Assembly, DescriptorMap };
+
+spv_target_env GetTargetEnv() {
+  switch (clspv::Option::SpvVersion()) {
+  case clspv::Option::SPIRVVersion::SPIRV_1_3:
+    return SPV_ENV_VULKAN_1_1;
+  case clspv::Option::SPIRVVersion::SPIRV_1_4:
+    return SPV_ENV_VULKAN_1_1_SPIRV_1_4;
+  case clspv::Option::SPIRVVersion::SPIRV_1_5:
+    return SPV_ENV_VULKAN_1_2;
+  default:
+    return SPV_ENV_VULKAN_1_0;
+  }
+}
+
+// Writes |words| as a C initializer list with one decimal word per line.
+// raw_ostream formats integers directly into its buffer, so this avoids the
+// cost of going through iostreams for large binaries.
+void WriteCInitList(llvm::raw_ostream &os, llvm::ArrayRef<uint32_t> words) {
+  os << "{";
+  for (size_t i = 0; i < words.size(); ++i) {
+    if (i != 0)
+      os << ",\n";
+    os << words[i];
+  }
+  os << "}\n";
+}
+
+// Writes |binary| to |filename| in the format given by |kind|. Returns 0 on
+// success.
+int WriteOutputFile(const std::string &filename, OutputKind kind,
+                    const std::vector<uint32_t> &binary) {
+  std::error_code error;
+  llvm::raw_fd_ostream os(filename, error, llvm::sys::fs::FA_Write);
+  if (error) {
+    llvm::errs() << "Unable to open output file '" << filename
+                 << "': " << error.message() << '\n';
+    return -1;
+  }
+
+  switch (kind) {
+  case OutputKind::Binary:
+    os.write(reinterpret_cast<const char *>(binary.data()),
+             binary.size() * sizeof(uint32_t));
+    break;
+  case OutputKind::CInitList:
+    WriteCInitList(os, binary);
+    break;
+  case OutputKind::Assembly: {
+    spvtools::SpirvTools tools(GetTargetEnv());
+    std::string text;
+    if (!tools.Disassemble(binary, &text,
+                           SPV_BINARY_TO_TEXT_OPTION_FRIENDLY_NAMES |
+                               SPV_BINARY_TO_TEXT_OPTION_INDENT)) {
+      llvm::errs() << "Failed to disassemble the SPIR-V binary\n";
+      return -1;
+    }
+    os << text;
+    break;
+  }
+  case OutputKind::DescriptorMap: {
+    std::ostringstream str;
+    if (!clspv::ParseReflection(binary, GetTargetEnv(), &str)) {
+      llvm::errs() << "Failed to parse the embedded reflection\n";
+      return -1;
+    }
+    os << str.str();
+    break;
+  }
+  }
+
+  os.close();
+  if (os.has_error()) {
+    llvm::errs() << "Unable to write output file '" << filename
+                 << "': " << os.error().message() << '\n';
+    os.clear_error();
+    return -1;
+  }
+
+  return 0;
+}
+
 bool LinkBuiltinLibrary(llvm::Module *module) {
   std::unique_ptr<llvm::MemoryBuffer> buffer(new OpenCLBuiltinMemoryBuffer(
       clspv_builtin_library_data, clspv_builtin_library_size - 1));
@@ -1026,27 +1171,30 @@ int Compile(const int argc, const char *const argv[]) {
   pm.run(*module);
 
   // Write outputs
-  std::error_code error;
+  // Wait until now to try writing the files so that we only write them on
+  // successful compilation. Every output is derived from the same in-memory
+  // binary.
+  std::vector<uint32_t> words(binary.size() / 4);
+  memcpy(words.data(), binary.data(), binary.size());
 
-  // Write the resulting binary.
-  // Wait until now to try writing the file so that we only write it on
-  // successful compilation.
+  const bool c_init_list = OutputFormat == "c";
   if (OutputFilename.empty()) {
-    if (OutputFormat == "c") {
-      OutputFilename = "a.spvinc";
-    } else {
-      OutputFilename = "a.spv";
-    }
+    OutputFilename = c_init_list ? "a.spvinc" : "a.spv";
   }
-  llvm::raw_fd_ostream outStream(OutputFilename, error,
-                                 llvm::sys::fs::FA_Write);
-
-  if (error) {
-    llvm::errs() << "Unable to open output file '" << OutputFilename
-                 << "': " << error.message() << '\n';
-    return -1;
+  const std::pair<const std::string &, OutputKind> outputs[] = {
+      {OutputFilename,
+       c_init_list ? OutputKind::CInitList : OutputKind::Binary},
+      {BinaryOutputFile, OutputKind::Binary},
+      {CInitListOutputFile, OutputKind::CInitList},
+      {AssemblyOutputFile, OutputKind::Assembly},
+      {DescriptorMapOutputFile, OutputKind::DescriptorMap},
+  };
+  for (const auto &output : outputs) {
+    if (output.first.empty())
+      continue;
+    if (auto error = WriteOutputFile(output.first, output.second, words))
+      return error;
   }
-  outStream << binaryStream.str();
 
   return 0;
 }
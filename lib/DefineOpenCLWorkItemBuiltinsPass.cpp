@@ -12,6 +12,10 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <array>
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/Instructions.h"
@@ -21,6 +25,7 @@
 #include "clspv/AddressSpace.h"
 #include "clspv/Option.h"
 
+#include "Builtins.h"
 #include "Constants.h"
 #include "Passes.h"
 #include "PushConstant.h"
@@ -53,6 +58,17 @@ struct DefineOpenCLWorkItemBuiltinsPass final : public ModulePass {
   bool defineEnqueuedLocalSizeBuiltin(Module &M);
 
   bool addWorkgroupSizeIfRequired(Module &M);
+
+  // Replaces the calls to the work-item builtin |FuncName| by its components,
+  // computed once at the entry of the calling function. Calls with a
+  // non-constant dimension select among the components, or |DefaultValue|
+  // for out of bounds dimensions.
+  bool specializeBuiltinCalls(Module &M, StringRef FuncName,
+                              unsigned DefaultValue);
+
+  // Declares the builtins used to lower async work-group copies and
+  // work_group_broadcast so that they are defined below.
+  bool declareLoweringBuiltins(Module &M);
 };
 } // namespace
 
@@ -70,6 +86,20 @@ ModulePass *createDefineOpenCLWorkItemBuiltinsPass() {
 bool DefineOpenCLWorkItemBuiltinsPass::runOnModule(Module &M) {
   bool changed = false;
 
+  if (clspv::Option::SpecializeWorkItemBuiltins()) {
+    // Done before the builtins are defined so that calls between builtins,
+    // like get_global_offset in get_global_id, are left alone.
+    changed |= specializeBuiltinCalls(M, "_Z13get_global_idj", 0);
+    changed |= specializeBuiltinCalls(M, "_Z14get_local_sizej", 1);
+    changed |= specializeBuiltinCalls(M, "_Z12get_local_idj", 0);
+    changed |= specializeBuiltinCalls(M, "_Z14get_num_groupsj", 1);
+    changed |= specializeBuiltinCalls(M, "_Z12get_group_idj", 0);
+    changed |= specializeBuiltinCalls(M, "_Z15get_global_sizej", 1);
+    changed |= specializeBuiltinCalls(M, "_Z17get_global_offsetj", 0);
+    changed |= specializeBuiltinCalls(M, "_Z23get_enqueued_local_sizej", 1);
+  }
+
+  changed |= declareLoweringBuiltins(M);
   changed |= defineGlobalOffsetBuiltin(M);
   changed |= defineGlobalIDBuiltin(M);
 
@@ -485,3 +515,92 @@ bool DefineOpenCLWorkItemBuiltinsPass::addWorkgroupSizeIfRequired(Module &M) {
 
   return false;
 }
+
+bool DefineOpenCLWorkItemBuiltinsPass::specializeBuiltinCalls(
+    Module &M, StringRef FuncName, unsigned DefaultValue) {
+  Function *F = M.getFunction(FuncName);
+
+  // If the builtin was not used in the module, there is nothing to do.
+  if (nullptr == F) {
+    return false;
+  }
+
+  SmallVector<CallInst *, 8> Calls;
+  for (auto *U : F->users()) {
+    if (auto *Call = dyn_cast<CallInst>(U)) {
+      if (Call->getCalledFunction() == F) {
+        Calls.push_back(Call);
+      }
+    }
+  }
+
+  // The work-item builtins do not change during the execution of a kernel, so
+  // each of their components is computed once per calling function. Calls
+  // with a constant dimension are folded into a single load once inlined, and
+  // so are the global and region offset additions of get_global_id.
+  DenseMap<Function *, std::array<Value *, 3>> Components;
+  auto getComponent = [&Components, F](Function *Caller, unsigned Dim) {
+    auto &Values = Components[Caller];
+    if (nullptr == Values[Dim]) {
+      auto InsertPt = Caller->getEntryBlock().getFirstInsertionPt();
+      while (isa<AllocaInst>(*InsertPt)) {
+        ++InsertPt;
+      }
+      IRBuilder<> Builder(&*InsertPt);
+      auto Call = Builder.CreateCall(F, Builder.getInt32(Dim));
+      Call->setCallingConv(F->getCallingConv());
+      Values[Dim] = Call;
+    }
+    return Values[Dim];
+  };
+
+  for (auto *Call : Calls) {
+    auto Caller = Call->getFunction();
+    auto Dim = Call->getArgOperand(0);
+    Value *Result = nullptr;
+    if (auto *ConstDim = dyn_cast<ConstantInt>(Dim)) {
+      if (ConstDim->getZExtValue() < 3) {
+        Result = getComponent(Caller, ConstDim->getZExtValue());
+      } else {
+        Result = ConstantInt::get(Call->getType(), DefaultValue);
+      }
+    } else {
+      IRBuilder<> Builder(Call);
+      Result = Builder.getInt32(DefaultValue);
+      for (int i = 2; i >= 0; --i) {
+        auto Cond = Builder.CreateICmpEQ(Dim, Builder.getInt32(i));
+        Result = Builder.CreateSelect(Cond, getComponent(Caller, i), Result);
+      }
+    }
+    Call->replaceAllUsesWith(Result);
+    Call->eraseFromParent();
+  }
+
+  return !Calls.empty();
+}
+
+bool DefineOpenCLWorkItemBuiltinsPass::declareLoweringBuiltins(Module &M) {
+  bool uses_local_id = false;
+  for (auto &F : M) {
+    auto type = Builtins::Lookup(&F).getType();
+    if (type == Builtins::kAsyncWorkGroupCopy ||
+        type == Builtins::kAsyncWorkGroupStridedCopy ||
+        type == Builtins::kWorkGroupBroadcast) {
+      uses_local_id = true;
+      break;
+    }
+  }
+
+  if (!uses_local_id) {
+    return false;
+  }
+
+  // ReplaceOpenCLBuiltinPass splits async copies across the work-group by
+  // local id and selects the work-item to broadcast from by local id.
+  IntegerType *IT = IntegerType::get(M.getContext(), 32);
+  FunctionType *FT = FunctionType::get(IT, {IT}, false);
+  M.getOrInsertFunction("_Z12get_local_idj", FT);
+  M.getOrInsertFunction("_Z14get_local_sizej", FT);
+
+  return true;
+}
@@ -26,6 +26,7 @@
 #include "llvm/Transforms/Utils/Cloning.h"
 #include "llvm/Transforms/Utils/Local.h"
 
+#include "clspv/Option.h"
 #include "clspv/Passes.h"
 
 #include "Builtins.h"
@@ -159,6 +160,10 @@ private:
   void cleanDeadGlobals();
 
 private:
+  /// The number of elements of the pieces long vectors are lowered to: 1 for
+  /// scalars or 4 for chunks of 4-element vectors.
+  unsigned ChunkArity = 1;
+
   /// A map between long-vector types and their equivalent representation.
   DenseMap<Type *, Type *> TypeMap;
 
@@ -210,8 +215,18 @@ void partitionInstructions(ArrayRef<WeakTrackingVH> Instructions,
   }
 }
 
-/// Get the scalar overload for the given LLVM @p Intrinsic.
-Function *getIntrinsicScalarVersion(Function &Intrinsic) {
+/// Get the type of the pieces of @p ChunkArity elements of type @p ScalarTy
+/// long vectors are lowered to.
+Type *getChunkType(Type *ScalarTy, unsigned ChunkArity) {
+  if (ChunkArity == 1) {
+    return ScalarTy;
+  }
+  return FixedVectorType::get(ScalarTy, ChunkArity);
+}
+
+/// Get the overload for pieces of @p ChunkArity elements, which is the scalar
+/// overload when @p ChunkArity is 1, for the given LLVM @p Intrinsic.
+Function *getIntrinsicChunkVersion(Function &Intrinsic, unsigned ChunkArity) {
   auto id = Intrinsic.getIntrinsicID();
   assert(id != Intrinsic::not_intrinsic);
 
@@ -237,11 +252,11 @@ Function *getIntrinsicScalarVersion(Function &Intrinsic) {
     assert(Success);
     (void)Success;
 
-    // Map vectors to scalars.
+    // Map vectors to scalars or chunks.
     for (auto *&Param : ParamTys) {
       // TODO Need support for other types, like pointers. Need test case.
       assert(Param->isVectorTy());
-      Param = Param->getScalarType();
+      Param = getChunkType(Param->getScalarType(), ChunkArity);
     }
 
     return Intrinsic::getDeclaration(Intrinsic.getParent(), id, ParamTys);
@@ -251,19 +266,24 @@ Function *getIntrinsicScalarVersion(Function &Intrinsic) {
 }
 
 std::string
-getMangledScalarName(const clspv::Builtins::FunctionInfo &VectorInfo) {
+getMangledChunkName(const clspv::Builtins::FunctionInfo &VectorInfo,
+                    unsigned ChunkArity) {
   // Copy the informations about the vector version.
   // Return type is not important for mangling.
-  // Only update arguments to make them scalars.
-  clspv::Builtins::FunctionInfo ScalarInfo = VectorInfo;
-  for (size_t i = 0; i < ScalarInfo.getParameterCount(); ++i) {
-    ScalarInfo.getParameter(i).vector_size = 0;
+  // Only update arguments to make them scalars or chunks.
+  clspv::Builtins::FunctionInfo ChunkInfo = VectorInfo;
+  for (size_t i = 0; i < ChunkInfo.getParameterCount(); ++i) {
+    auto &Param = ChunkInfo.getParameter(i);
+    Param.vector_size =
+        (ChunkArity == 1 || Param.vector_size == 0) ? 0 : ChunkArity;
   }
-  return clspv::Builtins::GetMangledFunctionName(ScalarInfo);
+  return clspv::Builtins::GetMangledFunctionName(ChunkInfo);
 }
 
-/// Get the scalar overload for the given OpenCL builtin function @p Builtin.
-Function *getBIFScalarVersion(Function &Builtin) {
+/// Get the overload for pieces of @p ChunkArity elements, which is the scalar
+/// overload when @p ChunkArity is 1, for the given OpenCL builtin function
+/// @p Builtin.
+Function *getBIFChunkVersion(Function &Builtin, unsigned ChunkArity) {
   assert(!Builtin.isIntrinsic());
   const auto &Info = clspv::Builtins::Lookup(&Builtin);
   assert(Info.getType() != clspv::Builtins::kBuiltinNone);
@@ -320,56 +340,95 @@ Function *getBIFScalarVersion(Function &Builtin) {
   case clspv::Builtins::kTan:
   case clspv::Builtins::kTanh:
   case clspv::Builtins::kTrunc: {
-    // Scalarise all the input/output types. Here we intentionally do not rely
-    // on getEquivalentType because we want the scalar overload.
-    SmallVector<Type *, 16> ScalarParamTys;
+    // Scalarise or chunk all the input/output types. Here we intentionally do
+    // not rely on getEquivalentType because we want the scalar or chunk
+    // overload.
+    SmallVector<Type *, 16> ChunkParamTys;
     for (auto &Param : Builtin.args()) {
       auto *ParamTy = Param.getType();
 
-      Type *ScalarParamTy = nullptr;
+      Type *ChunkParamTy = nullptr;
       if (ParamTy->isPointerTy()) {
         auto *PointeeTy = ParamTy->getPointerElementType();
         assert(PointeeTy->isVectorTy() && "Unsupported kind of pointer type.");
-        ScalarParamTy = PointerType::get(PointeeTy->getScalarType(),
-                                         ParamTy->getPointerAddressSpace());
+        auto *ChunkTy = getChunkType(PointeeTy->getScalarType(), ChunkArity);
+        ChunkParamTy =
+            PointerType::get(ChunkTy, ParamTy->getPointerAddressSpace());
+      } else if (ParamTy->isVectorTy()) {
+        ChunkParamTy = getChunkType(ParamTy->getScalarType(), ChunkArity);
       } else {
-        assert((ParamTy->isVectorTy() || ParamTy->isFloatingPointTy() ||
-                ParamTy->isIntegerTy()) &&
+        assert((ParamTy->isFloatingPointTy() || ParamTy->isIntegerTy()) &&
                "Unsupported kind of parameter type.");
-        ScalarParamTy = ParamTy->getScalarType();
+        ChunkParamTy = ParamTy;
       }
 
-      assert(ScalarParamTy);
-      ScalarParamTys.push_back(ScalarParamTy);
+      assert(ChunkParamTy);
+      ChunkParamTys.push_back(ChunkParamTy);
     }
 
     assert(Builtin.getReturnType()->isVectorTy());
-    Type *ReturnTy = Builtin.getReturnType()->getScalarType();
+    Type *ReturnTy =
+        getChunkType(Builtin.getReturnType()->getScalarType(), ChunkArity);
 
-    FunctionTy =
-        FunctionType::get(ReturnTy, ScalarParamTys, Builtin.isVarArg());
+    FunctionTy = FunctionType::get(ReturnTy, ChunkParamTys, Builtin.isVarArg());
     break;
   }
   }
 
   // Handle signedness of parameters by using clspv::Builtins API.
-  std::string ScalarName = getMangledScalarName(Info);
+  std::string ChunkName = getMangledChunkName(Info, ChunkArity);
 
-  // Get the scalar version, which might not already exist in the module.
+  // Get the scalar or chunk version, which might not already exist in the
+  // module.
   auto *M = Builtin.getParent();
-  auto *ScalarFn = M->getFunction(ScalarName);
+  auto *ChunkFn = M->getFunction(ChunkName);
 
-  if (ScalarFn == nullptr) {
-    ScalarFn = Function::Create(FunctionTy, Builtin.getLinkage(), ScalarName);
-    ScalarFn->setCallingConv(Builtin.getCallingConv());
-    ScalarFn->copyAttributesFrom(&Builtin);
+  if (ChunkFn == nullptr) {
+    ChunkFn = Function::Create(FunctionTy, Builtin.getLinkage(), ChunkName);
+    ChunkFn->setCallingConv(Builtin.getCallingConv());
+    ChunkFn->copyAttributesFrom(&Builtin);
 
-    M->getFunctionList().push_front(ScalarFn);
+    M->getFunctionList().push_front(ChunkFn);
   }
 
-  assert(Builtin.getCallingConv() == ScalarFn->getCallingConv());
+  assert(Builtin.getCallingConv() == ChunkFn->getCallingConv());
+
+  return ChunkFn;
+}
+
+/// Get the number of elements of the long vector lowered to @p AggregateTy.
+unsigned getLongVectorArity(Type *AggregateTy) {
+  unsigned Arity = AggregateTy->getStructNumElements();
+  auto *ChunkTy = AggregateTy->getStructElementType(0);
+  if (auto *ChunkVectorTy = dyn_cast<FixedVectorType>(ChunkTy)) {
+    Arity *= ChunkVectorTy->getNumElements();
+  }
+  return Arity;
+}
+
+/// Extract the element @p Index of the long vector lowered to @p Aggregate.
+Value *extractLongVectorElement(IRBuilder<> &B, Value *Aggregate,
+                                unsigned Index) {
+  auto *ChunkTy = Aggregate->getType()->getStructElementType(0);
+  if (auto *ChunkVectorTy = dyn_cast<FixedVectorType>(ChunkTy)) {
+    unsigned ChunkArity = ChunkVectorTy->getNumElements();
+    auto *Chunk = B.CreateExtractValue(Aggregate, Index / ChunkArity);
+    return B.CreateExtractElement(Chunk, Index % ChunkArity);
+  }
+  return B.CreateExtractValue(Aggregate, Index);
+}
 
-  return ScalarFn;
+/// Insert @p Element at @p Index in the long vector lowered to @p Aggregate.
+Value *insertLongVectorElement(IRBuilder<> &B, Value *Aggregate,
+                               Value *Element, unsigned Index) {
+  auto *ChunkTy = Aggregate->getType()->getStructElementType(0);
+  if (auto *ChunkVectorTy = dyn_cast<FixedVectorType>(ChunkTy)) {
+    unsigned ChunkArity = ChunkVectorTy->getNumElements();
+    Value *Chunk = B.CreateExtractValue(Aggregate, Index / ChunkArity);
+    Chunk = B.CreateInsertElement(Chunk, Element, Index % ChunkArity);
+    return B.CreateInsertValue(Aggregate, Chunk, Index / ChunkArity);
+  }
+  return B.CreateInsertValue(Aggregate, Element, Index);
 }
 
 /// Convert the given value @p V to a value of the given @p EquivalentTy.
@@ -395,19 +454,19 @@ Value *convertEquivalentValue(IRBuilder<> &B, Value *V, Type *EquivalentTy) {
   if (EquivalentTy->isVectorTy()) {
     assert(V->getType()->isStructTy());
 
-    unsigned Arity = V->getType()->getNumContainedTypes();
+    unsigned Arity = getLongVectorArity(V->getType());
     for (unsigned i = 0; i < Arity; ++i) {
-      Value *Scalar = B.CreateExtractValue(V, i);
+      Value *Scalar = extractLongVectorElement(B, V, i);
       NewValue = B.CreateInsertElement(NewValue, Scalar, i);
     }
   } else {
     assert(EquivalentTy->isStructTy());
     assert(V->getType()->isVectorTy());
 
-    unsigned Arity = EquivalentTy->getNumContainedTypes();
+    unsigned Arity = getLongVectorArity(EquivalentTy);
     for (unsigned i = 0; i < Arity; ++i) {
       Value *Scalar = B.CreateExtractElement(V, i);
-      NewValue = B.CreateInsertValue(NewValue, Scalar, i);
+      NewValue = insertLongVectorElement(B, NewValue, Scalar, i);
     }
   }
 
@@ -417,8 +476,8 @@ Value *convertEquivalentValue(IRBuilder<> &B, Value *V, Type *EquivalentTy) {
 using ScalarOperationFactory =
     std::function<Value *(IRBuilder<> & /* B */, ArrayRef<Value *> /* Args */)>;
 
-/// Scalarise the vector instruction @p I element-wise by invoking the operation
-/// @p ScalarOperation.
+/// Scalarise the vector instruction @p I element-wise, or chunk-wise when long
+/// vectors are lowered to chunks, by invoking the operation @p ScalarOperation.
 Value *convertVectorOperation(Instruction &I, Type *EquivalentReturnTy,
                               ArrayRef<Value *> EquivalentArgs,
                               ScalarOperationFactory ScalarOperation) {
@@ -448,7 +507,8 @@ Value *convertVectorOperation(Instruction &I, Type *EquivalentReturnTy,
       } else if (ArgTy->isStructTy()) {
         Args[j] = B.CreateExtractValue(EquivalentArgs[j], i);
       } else {
-        assert((ArgTy->isFloatingPointTy() || ArgTy->isIntegerTy()) &&
+        assert((ArgTy->isFloatingPointTy() || ArgTy->isIntegerTy() ||
+                ArgTy->isVectorTy()) &&
                "Unsupported kind of parameter type.");
         Args[j] = EquivalentArgs[j];
       }
@@ -532,6 +592,8 @@ Function *createFunctionWithMappedTypes(Function &F,
 }
 
 bool LongVectorLoweringPass::runOnModule(Module &M) {
+  ChunkArity = clspv::Option::LongVectorChunks() ? 4 : 1;
+
   bool Modified = runOnGlobals(M);
 
   for (auto &F : M.functions()) {
@@ -597,7 +659,17 @@ Value *LongVectorLoweringPass::visitConstant(Constant &Cst) {
       Scalars.push_back(Vector->getElementAsConstant(i));
     }
 
-    return ConstantStruct::get(cast<StructType>(EquivalentTy), Scalars);
+    if (ChunkArity == 1) {
+      return ConstantStruct::get(cast<StructType>(EquivalentTy), Scalars);
+    }
+
+    SmallVector<Constant *, 4> Chunks;
+    for (unsigned i = 0; i < Scalars.size(); i += ChunkArity) {
+      Chunks.push_back(
+          ConstantVector::get(makeArrayRef(Scalars).slice(i, ChunkArity)));
+    }
+
+    return ConstantStruct::get(cast<StructType>(EquivalentTy), Chunks);
   }
 
   if (auto *GV = dyn_cast<GlobalVariable>(&Cst)) {
@@ -817,7 +889,7 @@ Value *LongVectorLoweringPass::visitExtractElementInst(ExtractElementInst &I) {
   unsigned Index = CI->getZExtValue();
 
   IRBuilder<> B(&I);
-  auto *V = B.CreateExtractValue(EquivalentValue, Index);
+  auto *V = extractLongVectorElement(B, EquivalentValue, Index);
   registerReplacement(I, *V);
   return V;
 }
@@ -869,7 +941,7 @@ Value *LongVectorLoweringPass::visitInsertElementInst(InsertElementInst &I) {
   unsigned Index = CI->getZExtValue();
 
   IRBuilder<> B(&I);
-  auto *V = B.CreateInsertValue(EquivalentValue, ScalarElement, {Index});
+  auto *V = insertLongVectorElement(B, EquivalentValue, ScalarElement, Index);
   registerReplacement(I, *V);
   return V;
 }
@@ -982,7 +1054,7 @@ Value *LongVectorLoweringPass::visitShuffleVectorInst(ShuffleVectorInst &I) {
       return B.CreateExtractElement(Vector, Index);
     } else {
       assert(Vector->getType()->isStructTy());
-      return B.CreateExtractValue(Vector, Index);
+      return extractLongVectorElement(B, Vector, Index);
     }
   };
 
@@ -992,7 +1064,7 @@ Value *LongVectorLoweringPass::visitShuffleVectorInst(ShuffleVectorInst &I) {
       return B.CreateInsertElement(Vector, Scalar, Index);
     } else {
       assert(Vector->getType()->isStructTy());
-      return B.CreateInsertValue(Vector, Scalar, Index);
+      return insertLongVectorElement(B, Vector, Scalar, Index);
     }
   };
 
@@ -1117,8 +1189,14 @@ Type *LongVectorLoweringPass::getEquivalentTypeImpl(Type *Ty) {
       assert((ScalarTy->isFloatingPointTy() || ScalarTy->isIntegerTy()) &&
              "Unsupported scalar type");
 
-      SmallVector<Type *, 16> AggregateBody(Arity, ScalarTy);
       auto &C = Ty->getContext();
+      if (ChunkArity > 1 && Arity % ChunkArity == 0) {
+        SmallVector<Type *, 4> AggregateBody(
+            Arity / ChunkArity, getChunkType(ScalarTy, ChunkArity));
+        return StructType::get(C, AggregateBody);
+      }
+
+      SmallVector<Type *, 16> AggregateBody(Arity, ScalarTy);
       return StructType::get(C, AggregateBody);
     }
 
@@ -1268,9 +1346,9 @@ LongVectorLoweringPass::convertBuiltinCall(CallInst &VectorCall,
   if (ScalarFunction == nullptr) {
     // Handle both OpenCL builtin functions, available as simple declarations,
     // and LLVM intrinsics.
-    auto getter = VectorFunction->isIntrinsic() ? getIntrinsicScalarVersion
-                                                : getBIFScalarVersion;
-    ScalarFunction = getter(*VectorFunction);
+    auto getter = VectorFunction->isIntrinsic() ? getIntrinsicChunkVersion
+                                                : getBIFChunkVersion;
+    ScalarFunction = getter(*VectorFunction, ChunkArity);
     FunctionMap[VectorFunction] = ScalarFunction;
   }
   assert(ScalarFunction);
@@ -0,0 +1,119 @@
+// Copyright 2021 The Clspv Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <vector>
+
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/IR/Instructions.h"
+
+#include "Builtins.h"
+#include "MemoryAccess.h"
+
+using namespace llvm;
+
+namespace clspv {
+
+std::pair<bool, bool> HasReadsAndWrites(Value *V) {
+  // Atomics and OpenCL builtins modf and frexp are all represented as function
+  // calls.
+  //
+  // A user is interesting if reads or writes memory or could eventually read
+  // or write memory.
+  auto IsInterestingUser = [](const User *user) {
+    if (isa<StoreInst>(user) || isa<LoadInst>(user) || isa<CallInst>(user) ||
+        user->getType()->isPointerTy())
+      return true;
+    return false;
+  };
+
+  bool read = false;
+  bool write = false;
+  DenseSet<Value *> visited;
+  std::vector<std::pair<Value *, unsigned>> stack;
+  for (auto &Use : V->uses()) {
+    if (IsInterestingUser(Use.getUser()))
+      stack.push_back(std::make_pair(Use.getUser(), Use.getOperandNo()));
+  }
+
+  while (!stack.empty() && !(read && write)) {
+    Value *value = stack.back().first;
+    unsigned operand_no = stack.back().second;
+    stack.pop_back();
+    if (!visited.insert(value).second)
+      continue;
+
+    if (isa<LoadInst>(value)) {
+      read = true;
+    } else if (isa<StoreInst>(value)) {
+      write = true;
+    } else {
+      auto *call = dyn_cast<CallInst>(value);
+      if (call && !call->getCalledFunction()->isDeclaration()) {
+        // Trace through the function call and grab the right argument.
+        auto arg_iter = call->getCalledFunction()->arg_begin();
+        for (size_t i = 0; i != operand_no; ++i, ++arg_iter) {
+        }
+
+        for (auto &Use : arg_iter->uses()) {
+          auto *User = Use.getUser();
+          if (IsInterestingUser(User))
+            stack.push_back(std::make_pair(Use.getUser(), Use.getOperandNo()));
+        }
+      } else if (call) {
+        auto func_info = clspv::Builtins::Lookup(call->getCalledFunction());
+        // Note that image queries (e.g. get_image_width()) do not touch the
+        // actual image memory.
+        switch (func_info.getType()) {
+        case clspv::Builtins::kReadImagef:
+        case clspv::Builtins::kReadImagei:
+        case clspv::Builtins::kReadImageui:
+        case clspv::Builtins::kReadImageh:
+          read = true;
+          break;
+        case clspv::Builtins::kWriteImagef:
+        case clspv::Builtins::kWriteImagei:
+        case clspv::Builtins::kWriteImageui:
+        case clspv::Builtins::kWriteImageh:
+          write = true;
+          break;
+        case clspv::Builtins::kGetImageWidth:
+        case clspv::Builtins::kGetImageHeight:
+        case clspv::Builtins::kGetImageDepth:
+        case clspv::Builtins::kGetImageDim:
+          break;
+        default:
+          // For other calls, check the function attributes.
+          if (!call->getCalledFunction()->doesNotAccessMemory()) {
+            if (!call->getCalledFunction()->doesNotReadMemory())
+              read = true;
+            if (!call->getCalledFunction()->onlyReadsMemory())
+              write = true;
+          }
+          break;
+        }
+      } else {
+        // Trace uses that remain a pointer or a function calls.
+        for (auto &U : value->uses()) {
+          auto *User = U.getUser();
+          if (IsInterestingUser(User))
+            stack.push_back(std::make_pair(U.getUser(), U.getOperandNo()));
+        }
+      }
+    }
+  }
+
+  return std::make_pair(read, write);
+}
+
+} // namespace clspv
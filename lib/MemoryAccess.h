@@ -0,0 +1,34 @@
+// Copyright 2021 The Clspv Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CLSPV_LIB_MEMORY_ACCESS_H_
+#define CLSPV_LIB_MEMORY_ACCESS_H_
+
+#include <utility>
+
+#include "llvm/IR/Value.h"
+
+namespace clspv {
+
+// Returns a pair indicating if |V| is read and/or written to.
+// Traces the use chain looking for loads and stores and proceeding through
+// function calls until a non-pointer value is encountered.
+//
+// This function assumes loads, stores and function calls are the only
+// instructions that can read or write to memory.
+std::pair<bool, bool> HasReadsAndWrites(llvm::Value *V);
+
+} // namespace clspv
+
+#endif
@@ -0,0 +1,460 @@
+// Copyright 2021 The Clspv Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+
+#include "spirv/unified1/spirv.hpp"
+
+#include "clspv/AddressSpace.h"
+
+#include "Builtins.h"
+#include "Passes.h"
+#include "Types.h"
+
+using namespace llvm;
+
+#define DEBUG_TYPE "narrowbarriers"
+
+namespace {
+
+// The storage classes of memory semantics this pass narrows.
+const uint32_t kUniformMemory = spv::MemorySemanticsUniformMemoryMask;
+const uint32_t kWorkgroupMemory = spv::MemorySemanticsWorkgroupMemoryMask;
+const uint32_t kImageMemory = spv::MemorySemanticsImageMemoryMask;
+const uint32_t kAllMemory = kUniformMemory | kWorkgroupMemory | kImageMemory;
+
+// All the storage classes of memory semantics.
+const uint32_t kStorageClassMask =
+    spv::MemorySemanticsUniformMemoryMask |
+    spv::MemorySemanticsSubgroupMemoryMask |
+    spv::MemorySemanticsWorkgroupMemoryMask |
+    spv::MemorySemanticsCrossWorkgroupMemoryMask |
+    spv::MemorySemanticsAtomicCounterMemoryMask |
+    spv::MemorySemanticsImageMemoryMask;
+
+const uint32_t kOrderingMask = spv::MemorySemanticsAcquireMask |
+                               spv::MemorySemanticsReleaseMask |
+                               spv::MemorySemanticsAcquireReleaseMask |
+                               spv::MemorySemanticsSequentiallyConsistentMask;
+
+struct NarrowBarriersPass : public ModulePass {
+  static char ID;
+  NarrowBarriersPass() : ModulePass(ID) {}
+
+  bool runOnModule(Module &M) override;
+
+private:
+  // The memory read and written by an instruction, a block or a function, as
+  // memory semantics storage class bits.
+  struct Access {
+    uint32_t reads = 0;
+    uint32_t writes = 0;
+
+    Access &operator|=(const Access &other) {
+      reads |= other.reads;
+      writes |= other.writes;
+      return *this;
+    }
+  };
+
+  // Returns the opcode of |I| if it is a barrier or a fence, otherwise
+  // OpNop.
+  spv::Op GetBarrierOpcode(const Instruction &I) const;
+
+  // Returns the index of the memory scope and semantics operands of the
+  // barrier or fence |opcode|.
+  unsigned GetMemoryScopeIndex(spv::Op opcode) const {
+    return opcode == spv::OpControlBarrier ? 2 : 1;
+  }
+  unsigned GetSemanticsIndex(spv::Op opcode) const {
+    return opcode == spv::OpControlBarrier ? 3 : 2;
+  }
+
+  // Returns the memory accessed by |I|.
+  Access GetAccess(Instruction &I);
+
+  // Returns the memory accessed by |F| and its callees.
+  Access GetFunctionAccess(Function *F);
+
+  // Returns the memory accessed by |BB|.
+  Access GetBlockAccess(BasicBlock *BB);
+
+  // Removes the storage classes from the semantics of |barrier| that are not
+  // accessed on both sides of it, with at least one side writing. Returns
+  // true if the barrier was changed. |dead| is set if the barrier orders
+  // nothing anymore.
+  bool Narrow(CallInst *barrier, bool *dead);
+
+  // Merges the barriers and fences of |BB| that are not separated by any
+  // memory access. Returns true if |BB| was changed.
+  bool MergeAdjacent(BasicBlock &BB);
+
+  DenseMap<Function *, Access> function_access_;
+  DenseMap<BasicBlock *, Access> block_access_;
+};
+
+// Returns the storage class bit of the memory semantics ordering accesses to
+// memory in |address_space|, or 0 if no other invocation can access it.
+uint32_t GetStorageClassBit(unsigned address_space) {
+  switch (address_space) {
+  case clspv::AddressSpace::Global:
+    return kUniformMemory;
+  case clspv::AddressSpace::Local:
+    return kWorkgroupMemory;
+  case clspv::AddressSpace::Private:
+  case clspv::AddressSpace::Input:
+  case clspv::AddressSpace::ModuleScopePrivate:
+    // Private, function and input memory belong to a single invocation.
+    return 0;
+  case clspv::AddressSpace::Constant:
+  case clspv::AddressSpace::Uniform:
+  case clspv::AddressSpace::PushConstant:
+    // Constant memory is never written.
+    return 0;
+  default:
+    // Generic pointers, for instance, may point to global or local memory.
+    return kUniformMemory | kWorkgroupMemory;
+  }
+}
+
+// Returns the rank of |scope| in the order of inclusion of scopes.
+int ScopeRank(uint64_t scope) {
+  switch (scope) {
+  case spv::ScopeInvocation:
+    return 0;
+  case spv::ScopeSubgroup:
+    return 1;
+  case spv::ScopeWorkgroup:
+    return 2;
+  case spv::ScopeQueueFamily:
+    return 3;
+  case spv::ScopeDevice:
+    return 4;
+  default:
+    return 5;
+  }
+}
+
+// Returns the wider of the constant scopes |lhs| and |rhs|.
+Value *WiderScope(Value *lhs, Value *rhs) {
+  auto lhs_scope = cast<ConstantInt>(lhs)->getZExtValue();
+  auto rhs_scope = cast<ConstantInt>(rhs)->getZExtValue();
+  return ScopeRank(lhs_scope) >= ScopeRank(rhs_scope) ? lhs : rhs;
+}
+
+// Returns the union of the constant memory semantics |lhs| and |rhs|.
+Value *MergeSemantics(Value *lhs, Value *rhs) {
+  auto semantics = cast<ConstantInt>(lhs)->getZExtValue() |
+                   cast<ConstantInt>(rhs)->getZExtValue();
+  // Only one ordering may be specified.
+  const auto ordering = semantics & kOrderingMask;
+  if (ordering & spv::MemorySemanticsSequentiallyConsistentMask) {
+    semantics = (semantics & ~kOrderingMask) |
+                spv::MemorySemanticsSequentiallyConsistentMask;
+  } else if (ordering & (ordering - 1)) {
+    semantics = (semantics & ~kOrderingMask) |
+                spv::MemorySemanticsAcquireReleaseMask;
+  }
+  return ConstantInt::get(lhs->getType(), semantics);
+}
+
+} // namespace
+
+char NarrowBarriersPass::ID = 0;
+INITIALIZE_PASS(NarrowBarriersPass, "NarrowBarriers", "Narrow Barriers Pass",
+                false, false)
+
+namespace clspv {
+ModulePass *createNarrowBarriersPass() { return new NarrowBarriersPass(); }
+} // namespace clspv
+
+spv::Op NarrowBarriersPass::GetBarrierOpcode(const Instruction &I) const {
+  auto *call = dyn_cast<CallInst>(&I);
+  if (!call || !call->getCalledFunction() ||
+      clspv::Builtins::Lookup(call->getCalledFunction()).getType() !=
+          clspv::Builtins::kSpirvOp)
+    return spv::OpNop;
+
+  auto opcode = static_cast<spv::Op>(
+      cast<ConstantInt>(call->getArgOperand(0))->getZExtValue());
+  if (opcode == spv::OpControlBarrier || opcode == spv::OpMemoryBarrier)
+    return opcode;
+  return spv::OpNop;
+}
+
+NarrowBarriersPass::Access NarrowBarriersPass::GetAccess(Instruction &I) {
+  Access access;
+  if (auto *load = dyn_cast<LoadInst>(&I)) {
+    access.reads = GetStorageClassBit(load->getPointerAddressSpace());
+  } else if (auto *store = dyn_cast<StoreInst>(&I)) {
+    access.writes = GetStorageClassBit(store->getPointerAddressSpace());
+  } else if (auto *rmw = dyn_cast<AtomicRMWInst>(&I)) {
+    access.reads = access.writes =
+        GetStorageClassBit(rmw->getPointerAddressSpace());
+  } else if (auto *cmpxchg = dyn_cast<AtomicCmpXchgInst>(&I)) {
+    access.reads = access.writes =
+        GetStorageClassBit(cmpxchg->getPointerAddressSpace());
+  } else if (auto *call = dyn_cast<CallInst>(&I)) {
+    auto *callee = call->getCalledFunction();
+    if (!callee) {
+      access.reads = access.writes = kAllMemory;
+    } else if (!callee->isDeclaration()) {
+      access = GetFunctionAccess(callee);
+    } else if (GetBarrierOpcode(I) == spv::OpNop &&
+               !callee->doesNotAccessMemory()) {
+      // Builtins only access the memory they are given.
+      switch (clspv::Builtins::Lookup(callee).getType()) {
+      case clspv::Builtins::kReadImagef:
+      case clspv::Builtins::kReadImagei:
+      case clspv::Builtins::kReadImageui:
+      case clspv::Builtins::kReadImageh:
+        access.reads = kImageMemory;
+        break;
+      case clspv::Builtins::kWriteImagef:
+      case clspv::Builtins::kWriteImagei:
+      case clspv::Builtins::kWriteImageui:
+      case clspv::Builtins::kWriteImageh:
+        access.writes = kImageMemory;
+        break;
+      case clspv::Builtins::kGetImageWidth:
+      case clspv::Builtins::kGetImageHeight:
+      case clspv::Builtins::kGetImageDepth:
+      case clspv::Builtins::kGetImageDim:
+        break;
+      default:
+        for (auto &arg : call->args()) {
+          auto *ty = arg->getType();
+          if (!ty->isPointerTy())
+            continue;
+          uint32_t bit = clspv::IsImageType(ty)
+                             ? kImageMemory
+                             : GetStorageClassBit(ty->getPointerAddressSpace());
+          access.reads |= bit;
+          if (!callee->onlyReadsMemory())
+            access.writes |= bit;
+        }
+        break;
+      }
+    }
+  } else if (I.mayReadOrWriteMemory()) {
+    access.reads = access.writes = kAllMemory;
+  }
+  return access;
+}
+
+NarrowBarriersPass::Access NarrowBarriersPass::GetFunctionAccess(Function *F) {
+  auto iter = function_access_.find(F);
+  if (iter != function_access_.end())
+    return iter->second;
+
+  // OpenCL C does not allow recursion, but be conservative on cycles.
+  Access all;
+  all.reads = all.writes = kAllMemory;
+  function_access_[F] = all;
+
+  Access access;
+  for (auto &BB : *F) {
+    for (auto &I : BB) {
+      access |= GetAccess(I);
+    }
+  }
+  function_access_[F] = access;
+  return access;
+}
+
+NarrowBarriersPass::Access NarrowBarriersPass::GetBlockAccess(BasicBlock *BB) {
+  auto iter = block_access_.find(BB);
+  if (iter != block_access_.end())
+    return iter->second;
+
+  Access access;
+  for (auto &I : *BB) {
+    access |= GetAccess(I);
+  }
+  block_access_[BB] = access;
+  return access;
+}
+
+bool NarrowBarriersPass::Narrow(CallInst *barrier, bool *dead) {
+  *dead = false;
+  auto opcode = GetBarrierOpcode(*barrier);
+  const auto semantics_index = GetSemanticsIndex(opcode);
+  auto *semantics_value =
+      dyn_cast<ConstantInt>(barrier->getArgOperand(semantics_index));
+  if (!semantics_value)
+    return false;
+  const auto semantics = semantics_value->getZExtValue();
+
+  // Accesses in the block of the barrier.
+  auto *BB = barrier->getParent();
+  Access before;
+  Access after;
+  bool is_before = true;
+  for (auto &I : *BB) {
+    if (&I == barrier) {
+      is_before = false;
+      continue;
+    }
+    if (is_before) {
+      before |= GetAccess(I);
+    } else {
+      after |= GetAccess(I);
+    }
+  }
+
+  // Accesses in the blocks that can execute before or after the barrier. All
+  // the invocations run the same code, so these are also the accesses of the
+  // other invocations on each side of the barrier.
+  auto visit = [this, BB](SmallVectorImpl<BasicBlock *> &worklist,
+                          bool forward) {
+    Access access;
+    SmallPtrSet<BasicBlock *, 16> visited;
+    while (!worklist.empty()) {
+      auto *block = worklist.pop_back_val();
+      if (!visited.insert(block).second)
+        continue;
+      access |= GetBlockAccess(block);
+      if (block == BB)
+        continue;
+      if (forward) {
+        worklist.append(succ_begin(block), succ_end(block));
+      } else {
+        worklist.append(pred_begin(block), pred_end(block));
+      }
+    }
+    return access;
+  };
+  SmallVector<BasicBlock *, 16> worklist(pred_begin(BB), pred_end(BB));
+  before |= visit(worklist, false);
+  worklist.assign(succ_begin(BB), succ_end(BB));
+  after |= visit(worklist, true);
+
+  // An access must be ordered if it conflicts with an access on the other
+  // side of the barrier.
+  const uint32_t needed = (before.writes & (after.reads | after.writes)) |
+                          (after.writes & (before.reads | before.writes));
+  const auto narrowed = semantics & ~(kAllMemory & ~needed);
+  if (!(narrowed & kStorageClassMask)) {
+    *dead = true;
+    return true;
+  }
+  if (narrowed == semantics)
+    return false;
+
+  barrier->setArgOperand(
+      semantics_index, ConstantInt::get(semantics_value->getType(), narrowed));
+  return true;
+}
+
+bool NarrowBarriersPass::MergeAdjacent(BasicBlock &BB) {
+  bool changed = false;
+  CallInst *prev = nullptr;
+  for (auto &I : make_early_inc_range(BB)) {
+    auto opcode = GetBarrierOpcode(I);
+    if (opcode == spv::OpNop) {
+      if (I.mayReadOrWriteMemory())
+        prev = nullptr;
+      continue;
+    }
+
+    auto *barrier = cast<CallInst>(&I);
+    bool constant = true;
+    for (unsigned i = 1; i < barrier->getNumArgOperands(); ++i) {
+      constant &= isa<ConstantInt>(barrier->getArgOperand(i));
+    }
+    if (!constant) {
+      prev = nullptr;
+      continue;
+    }
+    if (!prev) {
+      prev = barrier;
+      continue;
+    }
+
+    // Keep the barrier with the stronger execution synchronization and widen
+    // its memory scope and semantics to cover the other one.
+    auto prev_opcode = GetBarrierOpcode(*prev);
+    auto *keep = prev;
+    auto *remove = barrier;
+    if (prev_opcode == spv::OpMemoryBarrier &&
+        opcode == spv::OpControlBarrier) {
+      std::swap(keep, remove);
+    }
+    const auto keep_opcode = GetBarrierOpcode(*keep);
+    const auto remove_opcode = GetBarrierOpcode(*remove);
+    if (keep_opcode == spv::OpControlBarrier &&
+        remove_opcode == spv::OpControlBarrier) {
+      keep->setArgOperand(
+          1, WiderScope(keep->getArgOperand(1), remove->getArgOperand(1)));
+    }
+    const auto keep_scope = GetMemoryScopeIndex(keep_opcode);
+    const auto remove_scope = GetMemoryScopeIndex(remove_opcode);
+    keep->setArgOperand(keep_scope,
+                        WiderScope(keep->getArgOperand(keep_scope),
+                                   remove->getArgOperand(remove_scope)));
+    const auto keep_semantics = GetSemanticsIndex(keep_opcode);
+    const auto remove_semantics = GetSemanticsIndex(remove_opcode);
+    keep->setArgOperand(
+        keep_semantics,
+        MergeSemantics(keep->getArgOperand(keep_semantics),
+                       remove->getArgOperand(remove_semantics)));
+    remove->eraseFromParent();
+    prev = keep;
+    changed = true;
+  }
+  return changed;
+}
+
+bool NarrowBarriersPass::runOnModule(Module &M) {
+  bool changed = false;
+  for (auto &F : M) {
+    // The accesses around barriers in other functions depend on their
+    // callers.
+    if (F.isDeclaration() || F.getCallingConv() != CallingConv::SPIR_KERNEL)
+      continue;
+
+    SmallVector<CallInst *, 8> barriers;
+    for (auto &BB : F) {
+      for (auto &I : BB) {
+        if (GetBarrierOpcode(I) != spv::OpNop) {
+          barriers.push_back(cast<CallInst>(&I));
+        }
+      }
+    }
+
+    // Barriers do not access memory, so removing one does not change the
+    // accesses seen by the others.
+    block_access_.clear();
+    for (auto *barrier : barriers) {
+      bool dead = false;
+      changed |= Narrow(barrier, &dead);
+      if (dead) {
+        barrier->eraseFromParent();
+      }
+    }
+
+    for (auto &BB : F) {
+      changed |= MergeAdjacent(BB);
+    }
+  }
+
+  return changed;
+}
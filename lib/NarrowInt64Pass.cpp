@@ -0,0 +1,301 @@
+// Copyright 2021 The Clspv Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Kernels often compute indices with 64-bit integers (e.g. long). Storage
+// buffer pointers are 32 bits wide, so only the low 32 bits of these indices
+// are used. The low 32 bits of additions, subtractions, multiplications,
+// bitwise operations and left shifts only depend on the low 32 bits of their
+// operands, so whole index expressions can be evaluated with 32-bit
+// arithmetic. This avoids 64-bit integer arithmetic, which many devices
+// emulate.
+//
+// The pass runs once the LLVM optimizations have settled the index
+// expressions, right before ReplaceLLVMIntrinsics, and well before the
+// control flow is structurized for the SPIR-V producer.
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/ValueHandle.h"
+#include "llvm/Pass.h"
+#include "llvm/Transforms/Utils/Local.h"
+
+#include "Passes.h"
+
+using namespace llvm;
+
+#define DEBUG_TYPE "narrowint64"
+
+namespace {
+
+// The maximum depth of the expressions rewritten.
+const unsigned kMaxDepth = 8;
+
+struct NarrowInt64Pass : public ModulePass {
+  static char ID;
+  NarrowInt64Pass() : ModulePass(ID) {}
+
+  bool runOnModule(Module &M) override;
+
+private:
+  // Returns true if the low 32 bits of |V| can be computed with 32-bit
+  // arithmetic.
+  bool CanNarrow(Value *V, unsigned depth = 0) const;
+
+  // Returns a 32-bit value equal to the low 32 bits of |V|. |V| must satisfy
+  // CanNarrow.
+  Value *Narrow(Value *V);
+
+  // Replaces the 64-bit index operand |index| of |I| by its low 32 bits.
+  // Returns true if the operand was replaced.
+  bool NarrowIndex(Instruction *I, unsigned index);
+
+  // Replaces the truncation |trunc| of a 64-bit value to 32 bits or less.
+  // Returns true if |trunc| was replaced.
+  bool NarrowTrunc(TruncInst *trunc);
+
+  // Replaces the comparison |cmp| of 64-bit values extended from 32 bits or
+  // less. Returns true if |cmp| was replaced.
+  bool NarrowCompare(ICmpInst *cmp);
+
+  DenseMap<Value *, Value *> narrowed_;
+  SmallVector<WeakTrackingVH, 16> dead_;
+};
+
+bool IsInt64(Value *V) { return V->getType()->isIntegerTy(64); }
+
+// Returns the value extended by |V| to 64 bits if it is a zero or sign
+// extension of a 32-bit or narrower integer.
+Value *GetExtendedValue(Value *V) {
+  if (!isa<ZExtInst>(V) && !isa<SExtInst>(V))
+    return nullptr;
+  auto *src = cast<CastInst>(V)->getOperand(0);
+  if (!src->getType()->isIntegerTy() ||
+      src->getType()->getIntegerBitWidth() > 32)
+    return nullptr;
+  return src;
+}
+
+} // namespace
+
+char NarrowInt64Pass::ID = 0;
+INITIALIZE_PASS(NarrowInt64Pass, "NarrowInt64",
+                "Narrow 64-bit integer arithmetic Pass", false, false)
+
+namespace clspv {
+ModulePass *createNarrowInt64Pass() { return new NarrowInt64Pass(); }
+} // namespace clspv
+
+bool NarrowInt64Pass::CanNarrow(Value *V, unsigned depth) const {
+  if (!IsInt64(V))
+    return false;
+  if (isa<ConstantInt>(V) || narrowed_.count(V))
+    return true;
+  if (GetExtendedValue(V))
+    return true;
+  if (depth == kMaxDepth)
+    return false;
+
+  auto *I = dyn_cast<Instruction>(V);
+  if (!I)
+    return false;
+
+  switch (I->getOpcode()) {
+  case Instruction::Add:
+  case Instruction::Sub:
+  case Instruction::Mul:
+  case Instruction::And:
+  case Instruction::Or:
+  case Instruction::Xor:
+    return CanNarrow(I->getOperand(0), depth + 1) &&
+           CanNarrow(I->getOperand(1), depth + 1);
+  case Instruction::Shl: {
+    auto *shift = dyn_cast<ConstantInt>(I->getOperand(1));
+    return shift && shift->getZExtValue() < 32 &&
+           CanNarrow(I->getOperand(0), depth + 1);
+  }
+  case Instruction::UDiv:
+  case Instruction::URem: {
+    // The quotient and remainder of 32-bit unsigned values fit in 32 bits.
+    auto is_unsigned_32 = [](Value *op) {
+      if (auto *C = dyn_cast<ConstantInt>(op))
+        return C->getValue().isIntN(32);
+      return isa<ZExtInst>(op) && GetExtendedValue(op);
+    };
+    return is_unsigned_32(I->getOperand(0)) &&
+           is_unsigned_32(I->getOperand(1));
+  }
+  case Instruction::Select:
+    return CanNarrow(I->getOperand(1), depth + 1) &&
+           CanNarrow(I->getOperand(2), depth + 1);
+  default:
+    return false;
+  }
+}
+
+Value *NarrowInt64Pass::Narrow(Value *V) {
+  auto iter = narrowed_.find(V);
+  if (iter != narrowed_.end())
+    return iter->second;
+
+  auto *int32_ty = Type::getInt32Ty(V->getContext());
+  if (auto *C = dyn_cast<ConstantInt>(V))
+    return ConstantInt::get(int32_ty, C->getValue().trunc(32));
+
+  auto *I = cast<Instruction>(V);
+  IRBuilder<> builder(I);
+  Value *result = nullptr;
+  if (auto *src = GetExtendedValue(I)) {
+    result = src;
+    if (src->getType() != int32_ty) {
+      result =
+          builder.CreateCast(cast<CastInst>(I)->getOpcode(), src, int32_ty);
+    }
+  } else if (auto *select = dyn_cast<SelectInst>(I)) {
+    auto *true_value = Narrow(select->getTrueValue());
+    auto *false_value = Narrow(select->getFalseValue());
+    result = builder.CreateSelect(select->getCondition(), true_value,
+                                  false_value);
+  } else {
+    auto *binop = cast<BinaryOperator>(I);
+    auto *lhs = Narrow(binop->getOperand(0));
+    auto *rhs = Narrow(binop->getOperand(1));
+    // Wrapping flags do not hold on the narrower type.
+    result = builder.CreateBinOp(binop->getOpcode(), lhs, rhs);
+  }
+
+  narrowed_[V] = result;
+  return result;
+}
+
+bool NarrowInt64Pass::NarrowIndex(Instruction *I, unsigned index) {
+  auto *op = I->getOperand(index);
+  if (!CanNarrow(op))
+    return false;
+
+  I->setOperand(index, Narrow(op));
+  if (auto *inst = dyn_cast<Instruction>(op))
+    dead_.push_back(inst);
+  return true;
+}
+
+bool NarrowInt64Pass::NarrowTrunc(TruncInst *trunc) {
+  auto *src = trunc->getOperand(0);
+  if (!CanNarrow(src))
+    return false;
+
+  Value *result = Narrow(src);
+  if (trunc->getType() != result->getType()) {
+    result = CastInst::Create(Instruction::Trunc, result, trunc->getType(), "",
+                              trunc);
+  }
+  trunc->replaceAllUsesWith(result);
+  dead_.push_back(trunc);
+  return true;
+}
+
+bool NarrowInt64Pass::NarrowCompare(ICmpInst *cmp) {
+  auto *lhs = cmp->getOperand(0);
+  auto *rhs = cmp->getOperand(1);
+  if (!IsInt64(lhs))
+    return false;
+  if (isa<ConstantInt>(lhs))
+    std::swap(lhs, rhs);
+
+  // Extensions of the same type preserve the order of their operands: zero
+  // extension the unsigned order only and sign extension both orders.
+  auto *lhs_src = GetExtendedValue(lhs);
+  if (!lhs_src)
+    return false;
+  const auto opcode = cast<CastInst>(lhs)->getOpcode();
+  auto *src_ty = lhs_src->getType();
+  const auto width = src_ty->getIntegerBitWidth();
+
+  Value *rhs_src = nullptr;
+  if (auto *C = dyn_cast<ConstantInt>(rhs)) {
+    const auto &value = C->getValue();
+    if (opcode == Instruction::SExt ? value.isSignedIntN(width)
+                                    : value.isIntN(width)) {
+      rhs_src = ConstantInt::get(src_ty, value.trunc(width));
+    }
+  } else if (auto *src = GetExtendedValue(rhs)) {
+    if (cast<CastInst>(rhs)->getOpcode() == opcode &&
+        src->getType() == src_ty) {
+      rhs_src = src;
+    }
+  }
+  if (!rhs_src)
+    return false;
+
+  auto predicate = cmp->getPredicate();
+  if (lhs != cmp->getOperand(0))
+    predicate = ICmpInst::getSwappedPredicate(predicate);
+  if (opcode == Instruction::ZExt && ICmpInst::isSigned(predicate))
+    predicate = ICmpInst::getUnsignedPredicate(predicate);
+
+  auto *result = new ICmpInst(cmp, predicate, lhs_src, rhs_src);
+  result->takeName(cmp);
+  cmp->replaceAllUsesWith(result);
+  dead_.push_back(cmp);
+  return true;
+}
+
+bool NarrowInt64Pass::runOnModule(Module &M) {
+  bool changed = false;
+  const auto &DL = M.getDataLayout();
+  for (auto &F : M) {
+    narrowed_.clear();
+    SmallVector<Instruction *, 16> worklist;
+    for (auto &BB : F) {
+      for (auto &I : BB) {
+        worklist.push_back(&I);
+      }
+    }
+
+    for (auto *I : worklist) {
+      if (auto *gep = dyn_cast<GetElementPtrInst>(I)) {
+        // Indices are truncated to the index width of the pointer.
+        if (gep->getType()->isVectorTy() ||
+            DL.getIndexSizeInBits(gep->getAddressSpace()) != 32)
+          continue;
+        for (unsigned i = 1; i < gep->getNumOperands(); ++i) {
+          changed |= NarrowIndex(gep, i);
+        }
+      } else if (isa<ExtractElementInst>(I)) {
+        changed |= NarrowIndex(I, 1);
+      } else if (isa<InsertElementInst>(I)) {
+        changed |= NarrowIndex(I, 2);
+      } else if (auto *trunc = dyn_cast<TruncInst>(I)) {
+        if (!trunc->getType()->isVectorTy() &&
+            trunc->getType()->getIntegerBitWidth() <= 32) {
+          changed |= NarrowTrunc(trunc);
+        }
+      } else if (auto *cmp = dyn_cast<ICmpInst>(I)) {
+        changed |= NarrowCompare(cmp);
+      }
+    }
+
+    // Deleting an instruction can delete others in the list.
+    for (auto &handle : dead_) {
+      if (auto *I = dyn_cast_or_null<Instruction>(handle))
+        RecursivelyDeleteTriviallyDeadInstructions(I);
+    }
+    dead_.clear();
+  }
+
+  return changed;
+}
@@ -98,6 +98,52 @@ llvm::cl::opt<bool> hack_block_order(
     "hack-block-order", llvm::cl::init(false),
     llvm::cl::desc("Order basic blocks using structured order"));
 
+llvm::cl::opt<clspv::Option::TargetDriver> target_driver(
+    "target-driver",
+    llvm::cl::desc("Select the driver to generate code for.  Enables the "
+                   "workarounds needed by that driver, in addition to those "
+                   "requested by -hack-* options"),
+    llvm::cl::init(clspv::Option::TargetDriver::Generic),
+    llvm::cl::values(
+        clEnumValN(clspv::Option::TargetDriver::Generic, "generic",
+                   "A driver needing no workaround"),
+        clEnumValN(clspv::Option::TargetDriver::Legacy, "legacy",
+                   "A driver needing every -hack-* workaround for driver "
+                   "bugs")));
+
+// Driver bugs worked around by code generation.
+enum DriverWorkaround : uint32_t {
+  kHackInitializers = 1 << 0,
+  kHackInserts = 1 << 1,
+  kHackSignedCompareFixup = 1 << 2,
+  kHackUndef = 1 << 3,
+  kHackPhis = 1 << 4,
+  kHackBlockOrder = 1 << 5,
+  kHackDistinctImageSampler = 1 << 6,
+};
+
+// The workarounds needed by each driver.  Add an entry here, rather than a
+// new global option, when a driver is found to need a subset of them.
+const struct {
+  clspv::Option::TargetDriver driver;
+  uint32_t workarounds;
+} kDriverProfiles[] = {
+    {clspv::Option::TargetDriver::Generic, 0},
+    {clspv::Option::TargetDriver::Legacy,
+     kHackInitializers | kHackInserts | kHackSignedCompareFixup | kHackUndef |
+         kHackPhis | kHackBlockOrder | kHackDistinctImageSampler},
+};
+
+// Returns true if the selected driver needs |workaround|.
+bool DriverNeeds(DriverWorkaround workaround) {
+  for (const auto &profile : kDriverProfiles) {
+    if (profile.driver == target_driver) {
+      return profile.workarounds & workaround;
+    }
+  }
+  return false;
+}
+
 llvm::cl::opt<bool>
     pod_ubo("pod-ubo", llvm::cl::init(false),
             llvm::cl::desc("POD kernel arguments are in uniform buffers"));
@@ -155,6 +201,11 @@ llvm::cl::opt<bool> long_vector_support(
     "long-vector", llvm::cl::init(false),
     llvm::cl::desc("Allow vectors of 8 and 16 elements. Experimental"));
 
+llvm::cl::opt<bool> long_vector_chunks(
+    "long-vector-chunks", llvm::cl::init(false),
+    llvm::cl::desc("Lower vectors of 8 and 16 elements to 4-element vectors "
+                   "instead of scalars. Requires -long-vector."));
+
 llvm::cl::opt<bool> cl_arm_non_uniform_work_group_size(
     "cl-arm-non-uniform-work-group-size", llvm::cl::init(false),
     llvm::cl::desc("Enable the cl_arm_non_uniform_work_group_size extension."));
@@ -255,6 +306,83 @@ static llvm::cl::opt<bool>
          llvm::cl::desc(
              "Enable support for FP64 (cl_khr_fp64 and/or __opencl_c_fp64)."));
 
+static llvm::cl::opt<bool> optimize_spirv_size(
+    "Os-spirv", llvm::cl::init(false),
+    llvm::cl::desc("Optimize the generated SPIR-V for size. Drops optional "
+                   "debug instructions."));
+
+static llvm::cl::opt<bool> stream_functions(
+    "stream-functions", llvm::cl::init(false),
+    llvm::cl::desc("Write each function to a temporary file as soon as its "
+                   "code is generated. Bounds peak memory use for very large "
+                   "modules. Disables ID compaction."));
+
+static llvm::cl::opt<bool>
+    debug_info("g", llvm::cl::init(false),
+               llvm::cl::desc("Emit OpLine debug instructions that map the "
+                              "generated code back to source lines."));
+
+static llvm::cl::opt<bool> vectorize_storage_buffer_accesses(
+    "vectorize-storage-buffer-accesses", llvm::cl::init(false),
+    llvm::cl::desc("Merge accesses to the components of a vector element of a "
+                   "buffer into a single vector access."));
+
+static llvm::cl::opt<bool> aggregate_subgroup_atomics(
+    "aggregate-subgroup-atomics", llvm::cl::init(false),
+    llvm::cl::desc("Perform a single atomic per subgroup for atomic additions "
+                   "to subgroup uniform addresses. Requires SPIR-V 1.3."));
+
+static llvm::cl::opt<bool> float_atomics(
+    "float-atomics", llvm::cl::init(false),
+    llvm::cl::desc("Use the SPV_EXT_shader_atomic_float_add and "
+                   "SPV_EXT_shader_atomic_float_min_max extensions for float "
+                   "atomic operations."));
+
+static llvm::cl::opt<bool> int64_atomics(
+    "int64-atomics", llvm::cl::init(false),
+    llvm::cl::desc("Enable support for cl_khr_int64_base_atomics and "
+                   "cl_khr_int64_extended_atomics."));
+
+static llvm::cl::opt<bool> physical_storage_buffers(
+    "physical-storage-buffers", llvm::cl::init(false),
+    llvm::cl::desc("Pass global pointer kernel arguments as 64-bit device "
+                   "addresses and access them through PhysicalStorageBuffer "
+                   "pointers instead of storage buffer descriptors."));
+
+static llvm::cl::opt<bool> narrow_barriers(
+    "narrow-barriers", llvm::cl::init(false),
+    llvm::cl::desc("Remove the memory semantics of barriers and fences that "
+                   "order no shared memory accesses, and remove the barriers "
+                   "and fences left ordering nothing."));
+
+static llvm::cl::opt<bool> narrow_int64(
+    "narrow-int64", llvm::cl::init(false),
+    llvm::cl::desc("Rewrite 64-bit integer arithmetic whose result is only "
+                   "used as 32-bit indices or compared after extension from "
+                   "32 bits to 32-bit arithmetic."));
+
+static llvm::cl::opt<bool> specialize_work_item_builtins(
+    "specialize-work-item-builtins", llvm::cl::init(false),
+    llvm::cl::desc("Compute the components of work-item builtins once at the "
+                   "entry of each function, and select from them for calls "
+                   "with a non-constant dimension."));
+
+static llvm::cl::opt<uint32_t> max_promoted_private_array_size(
+    "max-promoted-private-array-size", llvm::cl::init(0),
+    llvm::cl::desc("Promote dynamically indexed private arrays of at most this "
+                   "many elements to registers. 0 disables the promotion."));
+
+static llvm::cl::opt<bool> share_locals_across_barriers(
+    "share-locals-across-barriers", llvm::cl::init(false),
+    llvm::cl::desc("Share __local variables of the same type used by the same "
+                   "kernel when a work-group barrier separates their uses."));
+
+static llvm::cl::opt<bool> vulkan_memory_model(
+    "vulkan-memory-model", llvm::cl::init(false),
+    llvm::cl::desc("Generate code for the Vulkan memory model. Coherence is "
+                   "expressed on each memory access and on barrier and "
+                   "atomic semantics instead of by decorating variables."));
+
 static llvm::cl::opt<bool> uniform_workgroup_size(
     "uniform-workgroup-size", llvm::cl::init(false),
     llvm::cl::desc("Assume all workgroups are uniformly sized."));
@@ -271,13 +399,22 @@ bool DirectResourceAccess() {
 }
 bool ShareModuleScopeVariables() { return !no_share_module_scope_variables; }
 bool DistinctKernelDescriptorSets() { return distinct_kernel_descriptor_sets; }
-bool HackDistinctImageSampler() { return hack_dis; }
-bool HackInitializers() { return hack_initializers; }
-bool HackInserts() { return hack_inserts; }
-bool HackSignedCompareFixup() { return hack_signed_compare_fixup; }
-bool HackUndef() { return hack_undef; }
-bool HackPhis() { return hack_phis; }
-bool HackBlockOrder() { return hack_block_order; }
+bool HackDistinctImageSampler() {
+  return hack_dis || DriverNeeds(kHackDistinctImageSampler);
+}
+bool HackInitializers() {
+  return hack_initializers || DriverNeeds(kHackInitializers);
+}
+bool HackInserts() { return hack_inserts || DriverNeeds(kHackInserts); }
+bool HackSignedCompareFixup() {
+  return hack_signed_compare_fixup || DriverNeeds(kHackSignedCompareFixup);
+}
+bool HackUndef() { return hack_undef || DriverNeeds(kHackUndef); }
+bool HackPhis() { return hack_phis || DriverNeeds(kHackPhis); }
+bool HackBlockOrder() {
+  return hack_block_order || DriverNeeds(kHackBlockOrder);
+}
+TargetDriver Driver() { return target_driver; }
 bool ModuleConstantsInStorageBuffer() {
   return module_constants_in_storage_buffer;
 }
@@ -292,6 +429,7 @@ bool Std430UniformBufferLayout() { return std430_ubo_layout; }
 bool KeepUnusedArguments() { return keep_unused_arguments; }
 bool Int8Support() { return int8_support; }
 bool LongVectorSupport() { return long_vector_support; }
+bool LongVectorChunks() { return long_vector_chunks; }
 bool ImageSupport() { return images; }
 bool UseSamplerMap() { return use_sampler_map; }
 void SetUseSamplerMap(bool use) { use_sampler_map = use; }
@@ -337,6 +475,24 @@ bool FP64() { return fp64; }
 
 bool ArmNonUniformWorkGroupSize() { return cl_arm_non_uniform_work_group_size; }
 bool UniformWorkgroupSize() { return uniform_workgroup_size; }
+bool OptimizeSPIRVSize() { return optimize_spirv_size; }
+bool StreamFunctions() { return stream_functions; }
+bool DebugInfo() { return debug_info; }
+bool VectorizeStorageBufferAccesses() {
+  return vectorize_storage_buffer_accesses;
+}
+bool AggregateSubgroupAtomics() { return aggregate_subgroup_atomics; }
+bool FloatAtomics() { return float_atomics; }
+bool Int64Atomics() { return int64_atomics; }
+bool PhysicalStorageBuffers() { return physical_storage_buffers; }
+bool VulkanMemoryModel() { return vulkan_memory_model; }
+bool NarrowBarriers() { return narrow_barriers; }
+bool NarrowInt64() { return narrow_int64; }
+bool SpecializeWorkItemBuiltins() { return specialize_work_item_builtins; }
+uint32_t MaxPromotedPrivateArraySize() {
+  return max_promoted_private_array_size;
+}
+bool ShareLocalsAcrossBarriers() { return share_locals_across_barriers; }
 
 } // namespace Option
 } // namespace clspv
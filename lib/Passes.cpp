@@ -18,6 +18,7 @@ namespace llvm {
 
 void initializeClspvPasses(PassRegistry &r) {
   initializeAddFunctionAttributesPassPass(r);
+  initializeAggregateSubgroupAtomicsPassPass(r);
   initializeAutoPodArgsPassPass(r);
   initializeAllocateDescriptorsPassPass(r);
   initializeClusterModuleScopeConstantVarsPass(r);
@@ -35,10 +36,15 @@ void initializeClspvPasses(PassRegistry &r) {
   initializeInlineFuncWithSingleCallSitePassPass(r);
   initializeLongVectorLoweringPassPass(r);
   initializeMultiVersionUBOFunctionsPassPass(r);
+  initializeNarrowBarriersPassPass(r);
+  initializeNarrowInt64PassPass(r);
   initializeNativeMathPassPass(r);
   initializeOpenCLInlinerPassPass(r);
   initializeRemoveUnusedArgumentsPass(r);
+  initializePhysicalPointerArgsPassPass(r);
+  initializePromotePrivateArraysPassPass(r);
   initializeReorderBasicBlocksPassPass(r);
+  initializeReplaceFloatAtomicLoopsPassPass(r);
   initializeReplaceLLVMIntrinsicsPassPass(r);
   initializeReplaceOpenCLBuiltinPassPass(r);
   initializeReplacePointerBitcastPassPass(r);
@@ -60,6 +66,7 @@ void initializeClspvPasses(PassRegistry &r) {
   initializeUndoSRetPassPass(r);
   initializeUndoTranslateSamplerFoldPassPass(r);
   initializeUndoTruncateToOddIntegerPassPass(r);
+  initializeVectorizeStorageBufferAccessesPassPass(r);
   initializeZeroInitializeAllocasPassPass(r);
 }
 
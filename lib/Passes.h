@@ -21,6 +21,7 @@ class PassRegistry;
 // Individual pass initializers.  See the documentation for
 // initializeClspvPasses() in include/clspv/Passes.h.
 void initializeAddFunctionAttributesPassPass(PassRegistry &);
+void initializeAggregateSubgroupAtomicsPassPass(PassRegistry &);
 void initializeAutoPodArgsPassPass(PassRegistry &);
 void initializeAllocateDescriptorsPassPass(PassRegistry &);
 void initializeClusterModuleScopeConstantVarsPass(PassRegistry &);
@@ -38,10 +39,15 @@ void initializeInlineFuncWithPointerToFunctionArgPassPass(PassRegistry &);
 void initializeInlineFuncWithSingleCallSitePassPass(PassRegistry &);
 void initializeLongVectorLoweringPassPass(PassRegistry &);
 void initializeMultiVersionUBOFunctionsPassPass(PassRegistry &);
+void initializeNarrowBarriersPassPass(PassRegistry &);
+void initializeNarrowInt64PassPass(PassRegistry &);
 void initializeNativeMathPassPass(PassRegistry &);
 void initializeOpenCLInlinerPassPass(PassRegistry &);
 void initializeRemoveUnusedArgumentsPass(PassRegistry &);
+void initializePhysicalPointerArgsPassPass(PassRegistry &);
+void initializePromotePrivateArraysPassPass(PassRegistry &);
 void initializeReorderBasicBlocksPassPass(PassRegistry &);
+void initializeReplaceFloatAtomicLoopsPassPass(PassRegistry &);
 void initializeReplaceLLVMIntrinsicsPassPass(PassRegistry &);
 void initializeReplaceOpenCLBuiltinPassPass(PassRegistry &);
 void initializeReplacePointerBitcastPassPass(PassRegistry &);
@@ -63,6 +69,7 @@ void initializeUndoInstCombinePassPass(PassRegistry &);
 void initializeUndoSRetPassPass(PassRegistry &);
 void initializeUndoTranslateSamplerFoldPassPass(PassRegistry &);
 void initializeUndoTruncateToOddIntegerPassPass(PassRegistry &);
+void initializeVectorizeStorageBufferAccessesPassPass(PassRegistry &);
 void initializeZeroInitializeAllocasPassPass(PassRegistry &);
 } // namespace llvm
 
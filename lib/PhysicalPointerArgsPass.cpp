@@ -0,0 +1,142 @@
+// Copyright 2021 The Clspv Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+
+#include "clspv/AddressSpace.h"
+
+#include "Passes.h"
+
+using namespace llvm;
+
+#define DEBUG_TYPE "physicalpointerargs"
+
+namespace {
+struct PhysicalPointerArgsPass : public ModulePass {
+  static char ID;
+  PhysicalPointerArgsPass() : ModulePass(ID) {}
+
+  bool runOnModule(Module &M) override;
+
+private:
+  // Returns true if |Ty| is a pointer to global memory.
+  bool IsGlobalPointer(Type *Ty) const {
+    return Ty->isPointerTy() &&
+           Ty->getPointerAddressSpace() == clspv::AddressSpace::Global;
+  }
+
+  // Replaces the global pointer parameters of kernel |F| by 64-bit addresses.
+  void runOnFunction(Function &F);
+};
+} // namespace
+
+char PhysicalPointerArgsPass::ID = 0;
+INITIALIZE_PASS(PhysicalPointerArgsPass, "PhysicalPointerArgs",
+                "Physical Pointer Arguments Pass", false, false)
+
+namespace clspv {
+ModulePass *createPhysicalPointerArgsPass() {
+  return new PhysicalPointerArgsPass();
+}
+} // namespace clspv
+
+bool PhysicalPointerArgsPass::runOnModule(Module &M) {
+  SmallVector<Function *, 8> WorkList;
+  for (auto &F : M) {
+    if (F.isDeclaration() || F.getCallingConv() != CallingConv::SPIR_KERNEL)
+      continue;
+
+    for (auto &Arg : F.args()) {
+      if (IsGlobalPointer(Arg.getType())) {
+        WorkList.push_back(&F);
+        break;
+      }
+    }
+  }
+
+  for (auto *F : WorkList) {
+    runOnFunction(*F);
+  }
+
+  return !WorkList.empty();
+}
+
+void PhysicalPointerArgsPass::runOnFunction(Function &F) {
+  auto &M = *F.getParent();
+  auto &Context = M.getContext();
+  auto *AddressTy = Type::getInt64Ty(Context);
+
+  // Pointer attributes do not apply to the address.
+  SmallVector<Type *, 8> NewFuncParamTys;
+  AttributeList Attrs = F.getAttributes();
+  for (auto &Arg : F.args()) {
+    if (IsGlobalPointer(Arg.getType())) {
+      NewFuncParamTys.push_back(AddressTy);
+      Attrs = Attrs.removeParamAttributes(Context, Arg.getArgNo());
+    } else {
+      NewFuncParamTys.push_back(Arg.getType());
+    }
+  }
+
+  auto *NewFuncTy =
+      FunctionType::get(F.getReturnType(), NewFuncParamTys, false);
+  auto *NewFunc = Function::Create(NewFuncTy, F.getLinkage());
+  NewFunc->takeName(&F);
+  NewFunc->setCallingConv(F.getCallingConv());
+  NewFunc->setAttributes(Attrs);
+  NewFunc->copyMetadata(&F, 0);
+  M.getFunctionList().insertAfter(F.getIterator(), NewFunc);
+
+  // Move the body and rebuild each pointer from its address at the top of the
+  // kernel.
+  NewFunc->getBasicBlockList().splice(NewFunc->begin(),
+                                      F.getBasicBlockList());
+  IRBuilder<> Builder(&*NewFunc->getEntryBlock().getFirstInsertionPt());
+  auto NewArg = NewFunc->arg_begin();
+  for (auto &Arg : F.args()) {
+    NewArg->setName(Arg.getName());
+    if (IsGlobalPointer(Arg.getType())) {
+      Arg.replaceAllUsesWith(
+          Builder.CreateIntToPtr(&*NewArg, Arg.getType(), Arg.getName()));
+    } else {
+      Arg.replaceAllUsesWith(&*NewArg);
+    }
+    ++NewArg;
+  }
+
+  // Kernels called from other kernels receive the addresses of the pointers.
+  SmallVector<User *, 8> Users(F.user_begin(), F.user_end());
+  for (auto *U : Users) {
+    auto *Call = cast<CallInst>(U);
+    Builder.SetInsertPoint(Call);
+    SmallVector<Value *, 8> Args;
+    for (auto &Op : Call->args()) {
+      if (IsGlobalPointer(Op->getType())) {
+        Args.push_back(Builder.CreatePtrToInt(Op, AddressTy));
+      } else {
+        Args.push_back(Op);
+      }
+    }
+    auto *NewCall = Builder.CreateCall(NewFunc, Args);
+    NewCall->setCallingConv(Call->getCallingConv());
+    Call->replaceAllUsesWith(NewCall);
+    Call->eraseFromParent();
+  }
+
+  F.eraseFromParent();
+}
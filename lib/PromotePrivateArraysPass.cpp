@@ -0,0 +1,235 @@
+// Copyright 2021 The Clspv Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Private arrays indexed dynamically cannot be promoted to registers by
+// mem2reg or SROA, so they stay as Function storage class variables, which
+// most drivers place in scratch memory. This pass splits small arrays into one
+// variable per element, which mem2reg then promotes to registers:
+//
+//  - a load of a dynamically indexed element selects among the elements,
+//  - a store to a dynamically indexed element conditionally updates every
+//    element.
+
+#include <algorithm>
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+
+#include "clspv/Option.h"
+
+#include "Passes.h"
+
+using namespace llvm;
+
+#define DEBUG_TYPE "promoteprivatearrays"
+
+STATISTIC(NumArraysPromoted, "Number of private arrays promoted");
+STATISTIC(NumElementsPromoted,
+          "Number of private array elements promoted to registers");
+STATISTIC(NumSelectsGenerated,
+          "Number of selects generated for dynamically indexed accesses");
+
+namespace {
+
+struct PromotePrivateArraysPass : public ModulePass {
+  static char ID;
+  PromotePrivateArraysPass() : ModulePass(ID) {}
+
+  bool runOnModule(Module &M) override;
+
+private:
+  // Returns true if |alloca| is a small array only accessed element by
+  // element, or stored to as a whole with a constant.
+  bool CanPromote(AllocaInst *alloca) const;
+
+  // Replaces |alloca| by one variable per element.
+  void Promote(AllocaInst *alloca);
+};
+
+} // namespace
+
+char PromotePrivateArraysPass::ID = 0;
+INITIALIZE_PASS(PromotePrivateArraysPass, "PromotePrivateArrays",
+                "Promote Private Arrays Pass", false, false)
+
+namespace clspv {
+ModulePass *createPromotePrivateArraysPass() {
+  return new PromotePrivateArraysPass();
+}
+} // namespace clspv
+
+bool PromotePrivateArraysPass::CanPromote(AllocaInst *alloca) const {
+  auto *array_ty = dyn_cast<ArrayType>(alloca->getAllocatedType());
+  if (!array_ty || alloca->isArrayAllocation() ||
+      array_ty->getNumElements() == 0 ||
+      array_ty->getNumElements() >
+          clspv::Option::MaxPromotedPrivateArraySize())
+    return false;
+
+  auto *element_ty = array_ty->getElementType();
+  if (!element_ty->isIntOrIntVectorTy() && !element_ty->isFPOrFPVectorTy())
+    return false;
+
+  for (auto *user : alloca->users()) {
+    if (auto *store = dyn_cast<StoreInst>(user)) {
+      // Whole array initialization, e.g. by ZeroInitializeAllocasPass.
+      if (store->getPointerOperand() != alloca || store->isVolatile() ||
+          !isa<Constant>(store->getValueOperand()))
+        return false;
+    } else if (auto *gep = dyn_cast<GetElementPtrInst>(user)) {
+      if (gep->getPointerOperand() != alloca || gep->getNumIndices() != 2)
+        return false;
+      auto *first = dyn_cast<ConstantInt>(gep->getOperand(1));
+      if (!first || !first->isZero())
+        return false;
+      for (auto *gep_user : gep->users()) {
+        if (auto *load = dyn_cast<LoadInst>(gep_user)) {
+          if (load->isVolatile() || load->getType() != element_ty)
+            return false;
+        } else if (auto *store = dyn_cast<StoreInst>(gep_user)) {
+          if (store->getPointerOperand() != gep || store->isVolatile() ||
+              store->getValueOperand()->getType() != element_ty)
+            return false;
+        } else {
+          return false;
+        }
+      }
+    } else if (auto *cast = dyn_cast<BitCastInst>(user)) {
+      // Only lifetime markers are allowed to see the array as bytes.
+      for (auto *cast_user : cast->users()) {
+        auto *intrinsic = dyn_cast<IntrinsicInst>(cast_user);
+        if (!intrinsic || !intrinsic->isLifetimeStartOrEnd())
+          return false;
+      }
+    } else {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void PromotePrivateArraysPass::Promote(AllocaInst *alloca) {
+  auto *array_ty = cast<ArrayType>(alloca->getAllocatedType());
+  auto *element_ty = array_ty->getElementType();
+  const unsigned num_elements = array_ty->getNumElements();
+
+  SmallVector<AllocaInst *, 16> elements;
+  for (unsigned i = 0; i < num_elements; ++i) {
+    elements.push_back(new AllocaInst(
+        element_ty, alloca->getType()->getAddressSpace(),
+        alloca->getName() + "." + Twine(i), alloca));
+  }
+
+  SmallVector<Instruction *, 16> to_remove;
+  for (auto *user : alloca->users()) {
+    auto *inst = cast<Instruction>(user);
+    to_remove.push_back(inst);
+    if (auto *store = dyn_cast<StoreInst>(inst)) {
+      auto *value = cast<Constant>(store->getValueOperand());
+      for (unsigned i = 0; i < num_elements; ++i) {
+        new StoreInst(value->getAggregateElement(i), elements[i], store);
+      }
+    } else if (auto *gep = dyn_cast<GetElementPtrInst>(inst)) {
+      auto *index = gep->getOperand(2);
+      auto *const_index = dyn_cast<ConstantInt>(index);
+      for (auto *gep_user : gep->users()) {
+        auto *access = cast<Instruction>(gep_user);
+        to_remove.push_back(access);
+        IRBuilder<> builder(access);
+        if (const_index) {
+          // Out of bounds accesses are undefined.
+          auto *element =
+              elements[std::min<uint64_t>(const_index->getZExtValue(),
+                                          num_elements - 1)];
+          if (auto *load = dyn_cast<LoadInst>(access)) {
+            load->replaceAllUsesWith(builder.CreateLoad(element_ty, element));
+          } else {
+            builder.CreateStore(cast<StoreInst>(access)->getValueOperand(),
+                                element);
+          }
+          continue;
+        }
+
+        if (auto *load = dyn_cast<LoadInst>(access)) {
+          // Out of bounds accesses are undefined, so the last element is
+          // used for all the other indices.
+          Value *result =
+              builder.CreateLoad(element_ty, elements[num_elements - 1]);
+          for (int i = num_elements - 2; i >= 0; --i) {
+            auto *cond = builder.CreateICmpEQ(
+                index, ConstantInt::get(index->getType(), i));
+            auto *element = builder.CreateLoad(element_ty, elements[i]);
+            result = builder.CreateSelect(cond, element, result);
+            ++NumSelectsGenerated;
+          }
+          load->replaceAllUsesWith(result);
+        } else {
+          auto *value = cast<StoreInst>(access)->getValueOperand();
+          for (unsigned i = 0; i < num_elements; ++i) {
+            auto *cond = builder.CreateICmpEQ(
+                index, ConstantInt::get(index->getType(), i));
+            auto *old_value = builder.CreateLoad(element_ty, elements[i]);
+            builder.CreateStore(builder.CreateSelect(cond, value, old_value),
+                                elements[i]);
+            ++NumSelectsGenerated;
+          }
+        }
+      }
+    } else {
+      // Lifetime markers.
+      for (auto *cast_user : inst->users()) {
+        to_remove.push_back(cast<Instruction>(cast_user));
+      }
+    }
+  }
+
+  // Remove users before the values they use.
+  for (auto iter = to_remove.rbegin(); iter != to_remove.rend(); ++iter) {
+    (*iter)->eraseFromParent();
+  }
+  alloca->eraseFromParent();
+
+  ++NumArraysPromoted;
+  NumElementsPromoted += num_elements;
+}
+
+bool PromotePrivateArraysPass::runOnModule(Module &M) {
+  if (clspv::Option::MaxPromotedPrivateArraySize() == 0)
+    return false;
+
+  SmallVector<AllocaInst *, 8> allocas;
+  for (auto &F : M) {
+    for (auto &BB : F) {
+      for (auto &I : BB) {
+        if (auto *alloca = dyn_cast<AllocaInst>(&I)) {
+          if (CanPromote(alloca))
+            allocas.push_back(alloca);
+        }
+      }
+    }
+  }
+
+  for (auto *alloca : allocas) {
+    Promote(alloca);
+  }
+
+  return !allocas.empty();
+}
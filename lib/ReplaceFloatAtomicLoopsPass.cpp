@@ -0,0 +1,283 @@
+// Copyright 2021 The Clspv Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/Transforms/Utils/Local.h"
+
+#include "spirv/unified1/spirv.hpp"
+
+#include "Builtins.h"
+#include "Passes.h"
+#include "SPIRVOp.h"
+
+using namespace llvm;
+
+#define DEBUG_TYPE "replacefloatatomicloops"
+
+namespace {
+struct ReplaceFloatAtomicLoopsPass : public ModulePass {
+  static char ID;
+  ReplaceFloatAtomicLoopsPass() : ModulePass(ID) {}
+
+  bool runOnModule(Module &M) override;
+
+private:
+  // A compare-exchange loop implementing a floating-point atomic addition.
+  struct Loop {
+    CallInst *cmpxchg;
+    // The value compared against memory, as loaded before the loop or
+    // returned by the previous iteration.
+    PHINode *expected;
+    // The value added by every iteration.
+    Value *value;
+    // The block the loop exits to.
+    BasicBlock *exit;
+  };
+
+  // Returns true and fills |loop| if |call| is the compare-exchange of a
+  // floating-point addition loop.
+  bool IsFloatAddLoop(CallInst *call, Loop *loop);
+
+  // Returns the float pointer aliasing the integer pointer |ptr|, or nullptr
+  // if it cannot be recovered.
+  Value *GetFloatPointer(Value *ptr, Instruction *InsertBefore);
+
+  void Replace(const Loop &loop);
+};
+} // namespace
+
+char ReplaceFloatAtomicLoopsPass::ID = 0;
+INITIALIZE_PASS(ReplaceFloatAtomicLoopsPass, "ReplaceFloatAtomicLoops",
+                "Replace Float Atomic Loops Pass", false, false)
+
+namespace clspv {
+ModulePass *createReplaceFloatAtomicLoopsPass() {
+  return new ReplaceFloatAtomicLoopsPass();
+}
+} // namespace clspv
+
+namespace {
+
+// Returns the operand of |V| if it is a bitcast, otherwise |V|.
+Value *StripBitCast(Value *V) {
+  if (auto *cast = dyn_cast<BitCastInst>(V))
+    return cast->getOperand(0);
+  return V;
+}
+
+} // namespace
+
+bool ReplaceFloatAtomicLoopsPass::IsFloatAddLoop(CallInst *call, Loop *loop) {
+  auto *callee = call->getCalledFunction();
+  if (!callee ||
+      clspv::Builtins::Lookup(callee).getType() != clspv::Builtins::kSpirvOp)
+    return false;
+  if (cast<ConstantInt>(call->getArgOperand(0))->getZExtValue() !=
+      spv::OpAtomicCompareExchange)
+    return false;
+  if (!call->getType()->isIntegerTy(32) && !call->getType()->isIntegerTy(64))
+    return false;
+
+  // The loop is a single block branching back to itself.
+  auto *BB = call->getParent();
+  auto *br = dyn_cast<BranchInst>(BB->getTerminator());
+  if (!br || !br->isConditional())
+    return false;
+  unsigned exit_index = 0;
+  if (br->getSuccessor(0) == BB) {
+    exit_index = 1;
+  } else if (br->getSuccessor(1) != BB) {
+    return false;
+  }
+  loop->exit = br->getSuccessor(exit_index);
+  if (loop->exit == BB)
+    return false;
+
+  // The comparator is the value returned by the previous iteration.
+  auto *expected = dyn_cast<PHINode>(StripBitCast(call->getArgOperand(6)));
+  if (!expected || expected->getParent() != BB ||
+      expected->getNumIncomingValues() != 2 ||
+      StripBitCast(expected->getIncomingValueForBlock(BB)) != call)
+    return false;
+  loop->expected = expected;
+
+  // The new value is the expected value plus a loop invariant.
+  auto *fadd = dyn_cast<BinaryOperator>(StripBitCast(call->getArgOperand(5)));
+  if (!fadd || fadd->getOpcode() != Instruction::FAdd ||
+      fadd->getType()->getPrimitiveSizeInBits() !=
+          call->getType()->getPrimitiveSizeInBits())
+    return false;
+  unsigned value_index = 0;
+  if (StripBitCast(fadd->getOperand(0)) == expected) {
+    value_index = 1;
+  } else if (StripBitCast(fadd->getOperand(1)) != expected) {
+    return false;
+  }
+  loop->value = fadd->getOperand(value_index);
+  if (auto *I = dyn_cast<Instruction>(loop->value)) {
+    if (I->getParent() == BB)
+      return false;
+  }
+
+  // The loop exits once the exchange succeeded.
+  auto *cmp = dyn_cast<CmpInst>(br->getCondition());
+  if (!cmp)
+    return false;
+  auto *lhs = StripBitCast(cmp->getOperand(0));
+  auto *rhs = StripBitCast(cmp->getOperand(1));
+  if (!((lhs == call && rhs == expected) || (lhs == expected && rhs == call)))
+    return false;
+  switch (cmp->getPredicate()) {
+  case CmpInst::ICMP_EQ:
+    if (exit_index != 0)
+      return false;
+    break;
+  case CmpInst::ICMP_NE:
+    if (exit_index != 1)
+      return false;
+    break;
+  default:
+    return false;
+  }
+
+  // Nothing else may happen in the loop.
+  for (auto &I : *BB) {
+    if (&I == call || &I == expected || &I == fadd || &I == cmp || &I == br ||
+        isa<BitCastInst>(&I))
+      continue;
+    return false;
+  }
+
+  loop->cmpxchg = call;
+  return GetFloatPointer(call->getArgOperand(1), nullptr) != nullptr;
+}
+
+Value *ReplaceFloatAtomicLoopsPass::GetFloatPointer(Value *ptr,
+                                                    Instruction *InsertBefore) {
+  auto *int_ty = cast<PointerType>(ptr->getType())->getElementType();
+  auto IsFloatPointer = [int_ty](Value *V) {
+    auto *ptr_ty = dyn_cast<PointerType>(V->getType());
+    return ptr_ty && ptr_ty->getElementType()->isFloatingPointTy() &&
+           ptr_ty->getElementType()->getPrimitiveSizeInBits() ==
+               int_ty->getPrimitiveSizeInBits();
+  };
+
+  auto *base = ptr->stripPointerCasts();
+  if (IsFloatPointer(base))
+    return base;
+
+  // Instcombine rewrites a bitcast of a GEP into a GEP of a bitcast, so the
+  // element index can be reused on the original pointer.
+  auto *gep = dyn_cast<GetElementPtrInst>(base);
+  if (!gep || gep->getNumIndices() != 1)
+    return nullptr;
+  auto *gep_base = gep->getPointerOperand()->stripPointerCasts();
+  if (!IsFloatPointer(gep_base))
+    return nullptr;
+  if (!InsertBefore)
+    return gep_base;
+
+  IRBuilder<> Builder(InsertBefore);
+  return Builder.CreateGEP(gep_base, gep->getOperand(1));
+}
+
+void ReplaceFloatAtomicLoopsPass::Replace(const Loop &loop) {
+  //
+  // Original IR
+  // 1. loop:
+  // 2.   expected = phi [ init, entry ], [ old, loop ]
+  // 3.   desired = bitcast (fadd (bitcast expected), v)
+  // 4.   old = cmpxchg ptr, desired, expected
+  // 5.   br (icmp eq old, expected), exit, loop
+  //
+  // Transformed IR
+  // 1. loop:
+  // 2.   old = atomic fadd (bitcast ptr), v
+  // 3.   br exit
+  //
+  // On exit the exchanged and expected values are equal to the value read
+  // by the successful exchange, which the atomic addition returns.
+  //
+  auto *call = loop.cmpxchg;
+  auto *BB = call->getParent();
+  auto *float_ptr = GetFloatPointer(call->getArgOperand(1), call);
+  auto *float_ty = cast<PointerType>(float_ptr->getType())->getElementType();
+  auto *old = clspv::InsertSPIRVOp(
+      call, spv::OpAtomicFAddEXT, {Attribute::Convergent}, float_ty,
+      {float_ptr, call->getArgOperand(2), call->getArgOperand(3), loop.value});
+
+  // Redirect the uses outside the loop of any view of the old value.
+  SmallVector<Instruction *, 8> views;
+  for (auto &I : *BB) {
+    if (&I == call || &I == loop.expected ||
+        (isa<BitCastInst>(&I) &&
+         (StripBitCast(&I) == call || StripBitCast(&I) == loop.expected)))
+      views.push_back(&I);
+  }
+  IRBuilder<> Builder(call);
+  for (auto *view : views) {
+    Value *replacement = nullptr;
+    for (auto &use : make_early_inc_range(view->uses())) {
+      if (cast<Instruction>(use.getUser())->getParent() == BB)
+        continue;
+      if (!replacement)
+        replacement = Builder.CreateBitCast(old, view->getType());
+      use.set(replacement);
+    }
+  }
+
+  auto *br = BB->getTerminator();
+  BranchInst::Create(loop.exit, br);
+  br->eraseFromParent();
+  loop.expected->removeIncomingValue(BB, false);
+  call->replaceAllUsesWith(UndefValue::get(call->getType()));
+  call->eraseFromParent();
+
+  // The rest of the loop computed the operands of the exchange.
+  bool erased = true;
+  while (erased) {
+    erased = false;
+    for (auto &I : make_early_inc_range(reverse(*BB))) {
+      if (isInstructionTriviallyDead(&I)) {
+        I.eraseFromParent();
+        erased = true;
+      }
+    }
+  }
+}
+
+bool ReplaceFloatAtomicLoopsPass::runOnModule(Module &M) {
+  SmallVector<Loop, 8> loops;
+  for (auto &F : M) {
+    for (auto &BB : F) {
+      for (auto &I : BB) {
+        auto *call = dyn_cast<CallInst>(&I);
+        Loop loop;
+        if (call && IsFloatAddLoop(call, &loop)) {
+          loops.push_back(loop);
+        }
+      }
+    }
+  }
+
+  for (auto &loop : loops) {
+    Replace(loop);
+  }
+
+  return !loops.empty();
+}
@@ -18,6 +18,7 @@
 #include "llvm/IR/IntrinsicInst.h"
 #include "llvm/IR/Module.h"
 #include "llvm/Pass.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Transforms/Utils/Cloning.h"
 
@@ -32,6 +33,32 @@ using namespace llvm;
 #define DEBUG_TYPE "ReplaceLLVMIntrinsics"
 
 namespace {
+
+cl::opt<unsigned> MemIntrinsicLoopThreshold(
+    "mem-intrinsic-loop-threshold", cl::init(16), cl::Hidden,
+    cl::desc("Lower memcpy and memset of more than this many elements to a "
+             "loop instead of unrolled element accesses"));
+
+// Splits the block containing |InsertBefore| and emits a loop between the two
+// halves that calls |Body| with an i32 index running over [0, |Count|).
+void EmitCountedLoop(Instruction *InsertBefore, uint64_t Count,
+                     function_ref<void(IRBuilder<> &, Value *)> Body) {
+  auto *Entry = InsertBefore->getParent();
+  auto *Exit = Entry->splitBasicBlock(InsertBefore);
+  auto *Loop =
+      BasicBlock::Create(Entry->getContext(), "", Entry->getParent(), Exit);
+  Entry->getTerminator()->setSuccessor(0, Loop);
+
+  IRBuilder<> Builder(Loop);
+  auto *Index = Builder.CreatePHI(Builder.getInt32Ty(), 2);
+  Index->addIncoming(Builder.getInt32(0), Entry);
+  Body(Builder, Index);
+  auto *Next = Builder.CreateAdd(Index, Builder.getInt32(1));
+  Index->addIncoming(Next, Loop);
+  auto *Cond = Builder.CreateICmpULT(Next, Builder.getInt32(Count));
+  Builder.CreateCondBr(Cond, Loop, Exit);
+}
+
 struct ReplaceLLVMIntrinsicsPass final : public ModulePass {
   static char ID;
   ReplaceLLVMIntrinsicsPass() : ModulePass(ID) {}
@@ -199,17 +226,28 @@ bool ReplaceLLVMIntrinsicsPass::replaceMemset(Module &M) {
                "Null memset can't be divided evenly across multiple stores.");
         assert((num_stores & 0xFFFFFFFF) == num_stores);
 
-        // Generate the first store.
-        new StoreInst(Zero, NewArg, CI);
-
-        // Generate subsequent stores, but only if needed.
-        if (num_stores) {
-          auto I32Ty = Type::getInt32Ty(M.getContext());
-          auto One = ConstantInt::get(I32Ty, 1);
-          auto Ptr = NewArg;
-          for (uint32_t i = 1; i < num_stores; i++) {
-            Ptr = GetElementPtrInst::Create(PointeeTy, Ptr, {One}, "", CI);
-            new StoreInst(Zero, Ptr, CI);
+        if (num_stores > MemIntrinsicLoopThreshold) {
+          // Zero one element per iteration to keep the code size independent
+          // of the size of the memset.
+          EmitCountedLoop(CI, num_stores,
+                          [&](IRBuilder<> &Builder, Value *Index) {
+                            auto Ptr =
+                                Builder.CreateGEP(PointeeTy, NewArg, Index);
+                            Builder.CreateStore(Zero, Ptr);
+                          });
+        } else {
+          // Generate the first store.
+          new StoreInst(Zero, NewArg, CI);
+
+          // Generate subsequent stores, but only if needed.
+          if (num_stores) {
+            auto I32Ty = Type::getInt32Ty(M.getContext());
+            auto One = ConstantInt::get(I32Ty, 1);
+            auto Ptr = NewArg;
+            for (uint32_t i = 1; i < num_stores; i++) {
+              Ptr = GetElementPtrInst::Create(PointeeTy, Ptr, {One}, "", CI);
+              new StoreInst(Zero, Ptr, CI);
+            }
           }
         }
 
@@ -229,29 +267,44 @@ bool ReplaceLLVMIntrinsicsPass::replaceMemcpy(Module &M) {
   bool Changed = false;
   auto Layout = M.getDataLayout();
 
+  auto descend_type = [](Type *InType) {
+    Type *OutType = InType;
+    if (OutType->isStructTy()) {
+      OutType = OutType->getStructElementType(0);
+    } else if (OutType->isArrayTy()) {
+      OutType = OutType->getArrayElementType();
+    } else if (auto vec_type = dyn_cast<VectorType>(OutType)) {
+      OutType = vec_type->getElementType();
+    } else {
+      assert(false && "Don't know how to descend into type");
+    }
+
+    return OutType;
+  };
+
+  // Returns true if the last index of the element pointers of a pointer to
+  // |Ty| unpacked |NumUnpackings| times can be dynamic, i.e. it selects an
+  // element of an array or a vector rather than a member of a struct.
+  auto has_dynamic_last_index = [&descend_type](Type *Ty,
+                                                unsigned NumUnpackings) {
+    if (NumUnpackings == 0) {
+      return true;
+    }
+    for (unsigned unpacking = 1; unpacking < NumUnpackings; ++unpacking) {
+      Ty = descend_type(Ty);
+    }
+    return Ty->isArrayTy() || Ty->isVectorTy();
+  };
+
   // Unpack source and destination types until we find a matching
   // element type.  Count the number of levels we unpack for the
   // source and destination types.  So far this only works for
   // array types, but could be generalized to other regular types
   // like vectors.
-  auto match_types = [&Layout](CallInst &CI, uint64_t Size, Type **DstElemTy,
-                               Type **SrcElemTy, unsigned *NumDstUnpackings,
-                               unsigned *NumSrcUnpackings) {
-    auto descend_type = [](Type *InType) {
-      Type *OutType = InType;
-      if (OutType->isStructTy()) {
-        OutType = OutType->getStructElementType(0);
-      } else if (OutType->isArrayTy()) {
-        OutType = OutType->getArrayElementType();
-      } else if (auto vec_type = dyn_cast<VectorType>(OutType)) {
-        OutType = vec_type->getElementType();
-      } else {
-        assert(false && "Don't know how to descend into type");
-      }
-
-      return OutType;
-    };
-
+  auto match_types = [&Layout, &descend_type](
+                         CallInst &CI, uint64_t Size, Type **DstElemTy,
+                         Type **SrcElemTy, unsigned *NumDstUnpackings,
+                         unsigned *NumSrcUnpackings) {
     while (*SrcElemTy != *DstElemTy) {
       auto SrcElemSize = Layout.getTypeSizeInBits(*SrcElemTy);
       auto DstElemSize = Layout.getTypeSizeInBits(*DstElemTy);
@@ -408,16 +461,17 @@ bool ReplaceLLVMIntrinsicsPass::replaceMemcpy(Module &M) {
           FunctionType *NewFType = nullptr;
           Function *NewF = nullptr;
 
-          IRBuilder<> Builder(CI);
-          for (unsigned i = 0; i < Size / DstElemSize; ++i) {
-            auto Index = ConstantInt::get(I32Ty, i);
+          // Copies one element at |Index|. The matched element type is the
+          // widest one common to both sides, so each copy is as large as the
+          // types allow.
+          auto CopyElement = [&](IRBuilder<> &Builder, Value *Index) {
             SrcIndices.back() = Index;
             DstIndices.back() = Index;
 
             // Avoid the builder for Src in order to prevent the folder from
             // creating constant expressions for constant memcpys.
-            auto SrcElemPtr =
-                GetElementPtrInst::CreateInBounds(Src, SrcIndices, "", CI);
+            auto SrcElemPtr = Builder.Insert(
+                GetElementPtrInst::CreateInBounds(Src, SrcIndices));
             auto DstElemPtr = Builder.CreateGEP(Dst, DstIndices);
             SmallVector<Type *, 5> param_tys = {
                 DstElemPtr->getType(), SrcElemPtr->getType(), I32Ty, I32Ty};
@@ -437,6 +491,23 @@ bool ReplaceLLVMIntrinsicsPass::replaceMemcpy(Module &M) {
                                    : Function::Create(NewFType, F.getLinkage(),
                                                       SPIRVIntrinsic, &M);
             Builder.CreateCall(NewF, param_values, "");
+          };
+
+          // A loop indexes the innermost aggregates with a PHI, which is only
+          // valid for arrays and vectors.
+          const auto NumElems = Size / DstElemSize;
+          if (NumElems > MemIntrinsicLoopThreshold &&
+              has_dynamic_last_index(Dst->getType()->getPointerElementType(),
+                                     NumDstUnpackings) &&
+              has_dynamic_last_index(Src->getType()->getPointerElementType(),
+                                     NumSrcUnpackings)) {
+            // Large copies (e.g. of big private structs or arrays) become a
+            // loop so the code size does not grow with the copy.
+            EmitCountedLoop(CI, NumElems, CopyElement);
+          } else {
+            for (unsigned i = 0; i < NumElems; ++i) {
+              CopyElement(Builder, ConstantInt::get(I32Ty, i));
+            }
           }
         }
 
@@ -47,6 +47,12 @@ using namespace llvm;
 
 namespace {
 
+llvm::cl::opt<unsigned> WorkGroupScratchSize(
+    "work-group-collective-scratch-size", llvm::cl::init(128),
+    llvm::cl::Hidden,
+    llvm::cl::desc("The number of sub-groups per work-group supported by the "
+                   "work-group collective functions"));
+
 uint32_t clz(uint32_t v) {
   uint32_t r;
   uint32_t shift;
@@ -67,6 +73,16 @@ uint32_t clz(uint32_t v) {
   return r;
 }
 
+// Returns true if the value operand of the atomic builtin |FI| is a floating
+// point type.
+bool IsFloatAtomic(const Builtins::FunctionInfo &FI) {
+  if (FI.getParameterCount() < 2)
+    return false;
+  auto type_id = FI.getParameter(1).type_id;
+  return type_id == Type::HalfTyID || type_id == Type::FloatTyID ||
+         type_id == Type::DoubleTyID;
+}
+
 Type *getIntOrIntVectorTyForCast(LLVMContext &C, Type *Ty) {
   Type *IntTy = Type::getIntNTy(C, Ty->getScalarSizeInBits());
   if (auto vec_ty = dyn_cast<VectorType>(Ty)) {
@@ -76,6 +92,25 @@ Type *getIntOrIntVectorTyForCast(LLVMContext &C, Type *Ty) {
   return IntTy;
 }
 
+// Returns the pointer to |vec_type| that |ptr| was derived from through pointer
+// casts alone, or nullptr if there is none. vloadn and vstoren at index
+// |offset| through such a pointer access exactly the |offset|th vector, so the
+// access can be done with a single vector load or store. Three element vectors
+// are excluded because their allocation size includes a padding element, so
+// consecutive vectors are not contiguous in memory.
+Value *GetVectorBasePointer(Value *ptr, VectorType *vec_type) {
+  if (vec_type->getElementCount().getKnownMinValue() == 3)
+    return nullptr;
+
+  auto *base = ptr->stripPointerCasts();
+  auto *base_type = dyn_cast<PointerType>(base->getType());
+  if (!base_type || base_type->getElementType() != vec_type ||
+      base_type->getAddressSpace() != ptr->getType()->getPointerAddressSpace())
+    return nullptr;
+
+  return base;
+}
+
 Value *MemoryOrderSemantics(Value *order, bool is_global,
                             Instruction *InsertBefore,
                             spv::MemorySemanticsMask base_semantics,
@@ -245,6 +280,11 @@ private:
   bool replaceBarrier(Function &F, bool subgroup = false);
   bool replaceMemFence(Function &F, spv::MemorySemanticsMask semantics);
   bool replacePrefetch(Function &F);
+  bool replaceAsyncWorkGroupCopy(Function &F, bool strided);
+  bool replaceWaitGroupEvents(Function &F);
+  bool replaceWorkGroupCollective(Function &F, Builtins::BuiltinType type);
+  bool replaceWorkGroupBroadcast(Function &F);
+  GlobalVariable *getWorkGroupScratch(Module &M, Type *Ty);
   bool replaceRelational(Function &F, CmpInst::Predicate P);
   bool replaceIsInfAndIsNan(Function &F, spv::Op SPIRVOp, int32_t isvec);
   bool replaceIsFinite(Function &F);
@@ -419,6 +459,21 @@ bool ReplaceOpenCLBuiltinPass::runOnFunction(Function &F) {
   case Builtins::kSubGroupBarrier:
     return replaceBarrier(F, true);
 
+  case Builtins::kWorkGroupAll:
+  case Builtins::kWorkGroupAny:
+  case Builtins::kWorkGroupReduceAdd:
+  case Builtins::kWorkGroupReduceMin:
+  case Builtins::kWorkGroupReduceMax:
+  case Builtins::kWorkGroupScanExclusiveAdd:
+  case Builtins::kWorkGroupScanExclusiveMin:
+  case Builtins::kWorkGroupScanExclusiveMax:
+  case Builtins::kWorkGroupScanInclusiveAdd:
+  case Builtins::kWorkGroupScanInclusiveMin:
+  case Builtins::kWorkGroupScanInclusiveMax:
+    return replaceWorkGroupCollective(F, FI.getType());
+  case Builtins::kWorkGroupBroadcast:
+    return replaceWorkGroupBroadcast(F);
+
   case Builtins::kAtomicWorkItemFence:
     return replaceMemFence(F, spv::MemorySemanticsMaskNone);
   case Builtins::kMemFence:
@@ -498,6 +553,13 @@ bool ReplaceOpenCLBuiltinPass::runOnFunction(Function &F) {
     return replaceExplicitAtomics(F, spv::OpAtomicExchange);
   case Builtins::kAtomicFetchAdd:
   case Builtins::kAtomicFetchAddExplicit:
+    if (IsFloatAtomic(FI)) {
+      // Half additions need a separate extension.
+      if (!clspv::Option::FloatAtomics() ||
+          FI.getParameter(1).type_id == Type::HalfTyID)
+        break;
+      return replaceExplicitAtomics(F, spv::OpAtomicFAddEXT);
+    }
     return replaceExplicitAtomics(F, spv::OpAtomicIAdd);
   case Builtins::kAtomicFetchSub:
   case Builtins::kAtomicFetchSubExplicit:
@@ -513,11 +575,21 @@ bool ReplaceOpenCLBuiltinPass::runOnFunction(Function &F) {
     return replaceExplicitAtomics(F, spv::OpAtomicAnd);
   case Builtins::kAtomicFetchMin:
   case Builtins::kAtomicFetchMinExplicit:
+    if (IsFloatAtomic(FI)) {
+      if (!clspv::Option::FloatAtomics())
+        break;
+      return replaceExplicitAtomics(F, spv::OpAtomicFMinEXT);
+    }
     return replaceExplicitAtomics(F, FI.getParameter(1).is_signed
                                          ? spv::OpAtomicSMin
                                          : spv::OpAtomicUMin);
   case Builtins::kAtomicFetchMax:
   case Builtins::kAtomicFetchMaxExplicit:
+    if (IsFloatAtomic(FI)) {
+      if (!clspv::Option::FloatAtomics())
+        break;
+      return replaceExplicitAtomics(F, spv::OpAtomicFMaxEXT);
+    }
     return replaceExplicitAtomics(F, FI.getParameter(1).is_signed
                                          ? spv::OpAtomicSMax
                                          : spv::OpAtomicUMax);
@@ -643,6 +715,13 @@ bool ReplaceOpenCLBuiltinPass::runOnFunction(Function &F) {
   case Builtins::kPrefetch:
     return replacePrefetch(F);
 
+  case Builtins::kAsyncWorkGroupCopy:
+    return replaceAsyncWorkGroupCopy(F, false);
+  case Builtins::kAsyncWorkGroupStridedCopy:
+    return replaceAsyncWorkGroupCopy(F, true);
+  case Builtins::kWaitGroupEvents:
+    return replaceWaitGroupEvents(F);
+
   default:
     break;
   }
@@ -984,6 +1063,369 @@ bool ReplaceOpenCLBuiltinPass::replaceMemFence(
   });
 }
 
+bool ReplaceOpenCLBuiltinPass::replaceAsyncWorkGroupCopy(Function &F,
+                                                         bool strided) {
+  // DefineOpenCLWorkItemBuiltinsPass provides these whenever the module
+  // contains async copies.
+  auto &M = *F.getParent();
+  auto GetLocalId = M.getFunction("_Z12get_local_idj");
+  auto GetLocalSize = M.getFunction("_Z14get_local_sizej");
+  if (!GetLocalId || !GetLocalSize) {
+    return false;
+  }
+
+  return replaceCallsWithValue(F, [&](CallInst *CI) {
+    //
+    // The work-items of the group share the copy, each moving every
+    // get_local_linear_size()-th element starting at its own linear id:
+    //
+    // for (i = linear_id; i < num_gentypes; i += linear_size)
+    //   dst[i * dst_stride] = src[i * src_stride];
+    //
+    // Each work-item has finished its part on leaving the loop, so the
+    // returned event only needs to be consumed by wait_group_events.
+    //
+    auto Dst = CI->getArgOperand(0);
+    auto Src = CI->getArgOperand(1);
+    auto Event = CI->getArgOperand(CI->getNumArgOperands() - 1);
+
+    IRBuilder<> Builder(CI);
+    auto Int32Ty = Builder.getInt32Ty();
+    auto NumElements =
+        Builder.CreateZExtOrTrunc(CI->getArgOperand(2), Int32Ty);
+
+    Value *LocalId[3];
+    Value *LocalSize[3];
+    for (unsigned i = 0; i < 3; ++i) {
+      LocalId[i] = Builder.CreateCall(GetLocalId, {Builder.getInt32(i)});
+      LocalSize[i] = Builder.CreateCall(GetLocalSize, {Builder.getInt32(i)});
+    }
+    auto LinearId = Builder.CreateAdd(
+        LocalId[0],
+        Builder.CreateMul(LocalSize[0],
+                          Builder.CreateAdd(LocalId[1],
+                                            Builder.CreateMul(LocalSize[1],
+                                                              LocalId[2]))));
+    auto LinearSize = Builder.CreateMul(
+        LocalSize[0], Builder.CreateMul(LocalSize[1], LocalSize[2]));
+
+    auto Entry = CI->getParent();
+    auto Exit = Entry->splitBasicBlock(CI);
+    auto Header = BasicBlock::Create(M.getContext(), "async_copy.header",
+                                     Entry->getParent(), Exit);
+    auto Body = BasicBlock::Create(M.getContext(), "async_copy.body",
+                                   Entry->getParent(), Exit);
+    Entry->getTerminator()->setSuccessor(0, Header);
+
+    Builder.SetInsertPoint(Header);
+    auto Index = Builder.CreatePHI(Int32Ty, 2);
+    Index->addIncoming(LinearId, Entry);
+    Builder.CreateCondBr(Builder.CreateICmpULT(Index, NumElements), Body,
+                         Exit);
+
+    Builder.SetInsertPoint(Body);
+    Value *SrcIndex = Index;
+    Value *DstIndex = Index;
+    if (strided) {
+      // The stride applies to the global side of the copy.
+      auto Stride = Builder.CreateZExtOrTrunc(CI->getArgOperand(3), Int32Ty);
+      if (Dst->getType()->getPointerAddressSpace() ==
+          clspv::AddressSpace::Local) {
+        SrcIndex = Builder.CreateMul(Index, Stride);
+      } else {
+        DstIndex = Builder.CreateMul(Index, Stride);
+      }
+    }
+    auto Element = Builder.CreateLoad(Builder.CreateGEP(Src, SrcIndex));
+    Builder.CreateStore(Element, Builder.CreateGEP(Dst, DstIndex));
+    Index->addIncoming(Builder.CreateAdd(Index, LinearSize), Body);
+    Builder.CreateBr(Header);
+
+    return Event;
+  });
+}
+
+bool ReplaceOpenCLBuiltinPass::replaceWaitGroupEvents(Function &F) {
+  // The copies are complete when each work-item leaves them, so waiting only
+  // has to make every work-item's part visible to the rest of the group.
+  // Uniform memory is only included if some copy writes to global memory.
+  bool writes_global = false;
+  for (auto &G : *F.getParent()) {
+    auto type = Builtins::Lookup(&G).getType();
+    if ((type == Builtins::kAsyncWorkGroupCopy ||
+         type == Builtins::kAsyncWorkGroupStridedCopy) &&
+        G.arg_size() > 0 &&
+        G.getArg(0)->getType()->getPointerAddressSpace() ==
+            clspv::AddressSpace::Global) {
+      writes_global = true;
+    }
+  }
+
+  return replaceCallsWithValue(F, [writes_global](CallInst *CI) {
+    IRBuilder<> Builder(CI);
+    uint32_t semantics = spv::MemorySemanticsAcquireReleaseMask |
+                         spv::MemorySemanticsWorkgroupMemoryMask;
+    if (writes_global) {
+      semantics |= spv::MemorySemanticsUniformMemoryMask;
+    }
+    const auto ScopeWorkgroup = Builder.getInt32(spv::ScopeWorkgroup);
+    return clspv::InsertSPIRVOp(
+        CI, spv::OpControlBarrier,
+        {Attribute::NoDuplicate, Attribute::Convergent}, CI->getType(),
+        {ScopeWorkgroup, ScopeWorkgroup, Builder.getInt32(semantics)});
+  });
+}
+
+GlobalVariable *ReplaceOpenCLBuiltinPass::getWorkGroupScratch(Module &M,
+                                                              Type *Ty) {
+  // One scratch array per element type is shared by all the work-group
+  // collectives of the module. Each collective ends with a barrier so the
+  // next one can reuse it.
+  const std::string Name =
+      "__clspv_work_group_scratch." + Builtins::GetMangledTypeName(Ty);
+  if (auto GV = M.getNamedGlobal(Name)) {
+    return GV;
+  }
+  auto ArrayTy = ArrayType::get(Ty, WorkGroupScratchSize);
+  return new GlobalVariable(M, ArrayTy, false, GlobalValue::InternalLinkage,
+                            UndefValue::get(ArrayTy), Name, nullptr,
+                            GlobalValue::NotThreadLocal,
+                            clspv::AddressSpace::Local);
+}
+
+bool ReplaceOpenCLBuiltinPass::replaceWorkGroupCollective(
+    Function &F, Builtins::BuiltinType type) {
+  auto &M = *F.getParent();
+  auto &FI = Builtins::Lookup(&F);
+  auto Int32Ty = Type::getInt32Ty(M.getContext());
+
+  // work_group_all and work_group_any are the minimum and maximum of the
+  // predicates converted to 0 or 1.
+  bool IsPredicate =
+      type == Builtins::kWorkGroupAll || type == Builtins::kWorkGroupAny;
+  std::string Operation;
+  switch (type) {
+  case Builtins::kWorkGroupAll:
+    Operation = "reduce_min";
+    break;
+  case Builtins::kWorkGroupAny:
+    Operation = "reduce_max";
+    break;
+  default:
+    // Drop the "work_group_" prefix.
+    Operation = FI.getName().substr(11);
+    break;
+  }
+  bool IsScan = StringRef(Operation).startswith("scan_");
+  StringRef Kind = StringRef(Operation).substr(Operation.rfind('_') + 1);
+
+  // The scalar argument keeps its mangling (and with it its signedness) in
+  // the sub-group builtins and in min and max.
+  const std::string Prefix =
+      "_Z" + std::to_string(FI.getName().size()) + FI.getName();
+  std::string ArgMangling =
+      IsPredicate ? "j" : F.getName().substr(Prefix.size()).str();
+  Type *Ty = IsPredicate ? Int32Ty : F.getReturnType();
+
+  auto GetSubGroupBuiltin = [&](const std::string &Name, Type *RetTy,
+                                ArrayRef<Type *> Params) {
+    std::string Mangled = "_Z" + std::to_string(Name.size()) + Name +
+                          (Params.empty() ? "v" : ArgMangling);
+    auto Callee =
+        M.getOrInsertFunction(Mangled, FunctionType::get(RetTy, Params, false));
+    // Like the declarations from the OpenCL headers, the sub-group builtins
+    // must not be moved across control flow.
+    cast<Function>(Callee.getCallee())->addFnAttr(Attribute::Convergent);
+    return Callee;
+  };
+  auto SubGroupOp = GetSubGroupBuiltin("sub_group_" + Operation, Ty, {Ty});
+  auto SubGroupReduce =
+      GetSubGroupBuiltin("sub_group_reduce_" + Kind.str(), Ty, {Ty});
+  auto GetSubGroupId = GetSubGroupBuiltin("get_sub_group_id", Int32Ty, {});
+  auto GetSubGroupLocalId =
+      GetSubGroupBuiltin("get_sub_group_local_id", Int32Ty, {});
+  auto GetNumSubGroups = GetSubGroupBuiltin("get_num_sub_groups", Int32Ty, {});
+
+  // Combines the partial results of two sub-groups.
+  FunctionCallee MinMax;
+  if (Kind != "add") {
+    bool IsFloat = Ty->isFloatingPointTy();
+    std::string Name = (IsFloat ? "f" : "") + Kind.str();
+    MinMax = M.getOrInsertFunction(
+        "_Z" + std::to_string(Name.size()) + Name + ArgMangling + ArgMangling,
+        FunctionType::get(Ty, {Ty, Ty}, false));
+  }
+  auto Combine = [&](IRBuilder<> &Builder, Value *A, Value *B) -> Value * {
+    if (Kind != "add") {
+      return Builder.CreateCall(MinMax, {A, B});
+    }
+    return Ty->isFloatingPointTy() ? Builder.CreateFAdd(A, B)
+                                   : Builder.CreateAdd(A, B);
+  };
+
+  auto Scratch = getWorkGroupScratch(M, Ty);
+  const auto ScopeWorkgroup = ConstantInt::get(Int32Ty, spv::ScopeWorkgroup);
+  const auto Semantics =
+      ConstantInt::get(Int32Ty, spv::MemorySemanticsAcquireReleaseMask |
+                                    spv::MemorySemanticsWorkgroupMemoryMask);
+  auto InsertBarrier = [&](Instruction *InsertBefore) {
+    clspv::InsertSPIRVOp(InsertBefore, spv::OpControlBarrier,
+                         {Attribute::NoDuplicate, Attribute::Convergent},
+                         Type::getVoidTy(M.getContext()),
+                         {ScopeWorkgroup, ScopeWorkgroup, Semantics});
+  };
+
+  return replaceCallsWithValue(F, [&](CallInst *CI) {
+    //
+    // Each sub-group computes its part with a sub-group operation and its
+    // first invocation publishes the sub-group total to the scratch array.
+    // The totals of the preceding sub-groups (scan) or of all the sub-groups
+    // (reduce) are then combined by every invocation:
+    //
+    // local = sub_group_<op>(x);
+    // if (get_sub_group_local_id() == 0)
+    //   scratch[get_sub_group_id()] = sub_group_reduce_<kind>(x);
+    // barrier();
+    // acc = scratch[0];
+    // for (i = 1; i < (scan ? get_sub_group_id() : get_num_sub_groups()); ++i)
+    //   acc = combine(acc, scratch[i]);
+    // barrier();
+    // result = reduce ? acc
+    //                 : (get_sub_group_id() == 0 ? local : combine(acc, local));
+    //
+    IRBuilder<> Builder(CI);
+    Value *X = CI->getArgOperand(0);
+    if (IsPredicate) {
+      X = Builder.CreateZExt(
+          Builder.CreateICmpNE(X, ConstantInt::get(X->getType(), 0)), Int32Ty);
+    }
+    auto Local = Builder.CreateCall(SubGroupOp, {X});
+    Value *Total = IsScan ? Builder.CreateCall(SubGroupReduce, {X}) : Local;
+    auto SubGroupId = Builder.CreateCall(GetSubGroupId);
+    auto IsFirst = Builder.CreateICmpEQ(Builder.CreateCall(GetSubGroupLocalId),
+                                        Builder.getInt32(0));
+    Value *Count = IsScan ? static_cast<Value *>(SubGroupId)
+                          : Builder.CreateCall(GetNumSubGroups);
+
+    auto Entry = CI->getParent();
+    auto Exit = Entry->splitBasicBlock(CI);
+    auto Func = Entry->getParent();
+    auto Publish = BasicBlock::Create(M.getContext(), "work_group.publish",
+                                      Func, Exit);
+    auto Gather =
+        BasicBlock::Create(M.getContext(), "work_group.gather", Func, Exit);
+    auto Header =
+        BasicBlock::Create(M.getContext(), "work_group.header", Func, Exit);
+    auto Body =
+        BasicBlock::Create(M.getContext(), "work_group.body", Func, Exit);
+    Entry->getTerminator()->eraseFromParent();
+    Builder.SetInsertPoint(Entry);
+    Builder.CreateCondBr(IsFirst, Publish, Gather);
+
+    Builder.SetInsertPoint(Publish);
+    Builder.CreateStore(Total, Builder.CreateGEP(Scratch, {Builder.getInt32(0),
+                                                           SubGroupId}));
+    Builder.CreateBr(Gather);
+
+    Builder.SetInsertPoint(Gather);
+    auto ToHeader = Builder.CreateBr(Header);
+    InsertBarrier(ToHeader);
+    Builder.SetInsertPoint(ToHeader);
+    auto First = Builder.CreateLoad(
+        Builder.CreateGEP(Scratch, {Builder.getInt32(0), Builder.getInt32(0)}));
+
+    Builder.SetInsertPoint(Header);
+    auto Index = Builder.CreatePHI(Int32Ty, 2);
+    Index->addIncoming(Builder.getInt32(1), Gather);
+    auto Acc = Builder.CreatePHI(Ty, 2);
+    Acc->addIncoming(First, Gather);
+    Builder.CreateCondBr(Builder.CreateICmpULT(Index, Count), Body, Exit);
+
+    Builder.SetInsertPoint(Body);
+    auto Partial = Builder.CreateLoad(
+        Builder.CreateGEP(Scratch, {Builder.getInt32(0), Index}));
+    Acc->addIncoming(Combine(Builder, Acc, Partial), Body);
+    Index->addIncoming(Builder.CreateAdd(Index, Builder.getInt32(1)), Body);
+    Builder.CreateBr(Header);
+
+    // Keep the scratch array from being overwritten by a following
+    // collective while other sub-groups still read it.
+    InsertBarrier(CI);
+    Builder.SetInsertPoint(CI);
+    Value *Result = Acc;
+    if (IsScan) {
+      Result = Builder.CreateSelect(
+          Builder.CreateICmpEQ(SubGroupId, Builder.getInt32(0)), Local,
+          Combine(Builder, Acc, Local));
+    }
+    if (IsPredicate) {
+      Result = Builder.CreateZExtOrTrunc(Result, CI->getType());
+    }
+    return Result;
+  });
+}
+
+bool ReplaceOpenCLBuiltinPass::replaceWorkGroupBroadcast(Function &F) {
+  // DefineOpenCLWorkItemBuiltinsPass provides get_local_id whenever the
+  // module contains work_group_broadcast.
+  auto &M = *F.getParent();
+  auto GetLocalId = M.getFunction("_Z12get_local_idj");
+  if (!GetLocalId) {
+    return false;
+  }
+
+  auto Int32Ty = Type::getInt32Ty(M.getContext());
+  auto Scratch = getWorkGroupScratch(M, F.getReturnType());
+  const auto ScopeWorkgroup = ConstantInt::get(Int32Ty, spv::ScopeWorkgroup);
+  const auto Semantics =
+      ConstantInt::get(Int32Ty, spv::MemorySemanticsAcquireReleaseMask |
+                                    spv::MemorySemanticsWorkgroupMemoryMask);
+  auto InsertBarrier = [&](Instruction *InsertBefore) {
+    clspv::InsertSPIRVOp(InsertBefore, spv::OpControlBarrier,
+                         {Attribute::NoDuplicate, Attribute::Convergent},
+                         Type::getVoidTy(M.getContext()),
+                         {ScopeWorkgroup, ScopeWorkgroup, Semantics});
+  };
+
+  return replaceCallsWithValue(F, [&](CallInst *CI) {
+    //
+    // if (get_local_id(0) == x && get_local_id(1) == y && ...)
+    //   scratch[0] = a;
+    // barrier();
+    // result = scratch[0];
+    // barrier();
+    //
+    IRBuilder<> Builder(CI);
+    Value *IsSource = Builder.getTrue();
+    for (unsigned i = 1; i < CI->getNumArgOperands(); ++i) {
+      auto Id = Builder.CreateCall(GetLocalId, {Builder.getInt32(i - 1)});
+      auto Wanted = Builder.CreateZExtOrTrunc(CI->getArgOperand(i), Int32Ty);
+      IsSource = Builder.CreateAnd(IsSource, Builder.CreateICmpEQ(Id, Wanted));
+    }
+
+    auto Entry = CI->getParent();
+    auto Exit = Entry->splitBasicBlock(CI);
+    auto Publish = BasicBlock::Create(M.getContext(), "work_group.publish",
+                                      Entry->getParent(), Exit);
+    Entry->getTerminator()->eraseFromParent();
+    Builder.SetInsertPoint(Entry);
+    Builder.CreateCondBr(IsSource, Publish, Exit);
+
+    Builder.SetInsertPoint(Publish);
+    auto Slot =
+        Builder.CreateGEP(Scratch, {Builder.getInt32(0), Builder.getInt32(0)});
+    Builder.CreateStore(CI->getArgOperand(0), Slot);
+    Builder.CreateBr(Exit);
+
+    InsertBarrier(CI);
+    Builder.SetInsertPoint(CI);
+    auto Result = Builder.CreateLoad(
+        Builder.CreateGEP(Scratch, {Builder.getInt32(0), Builder.getInt32(0)}));
+    InsertBarrier(CI);
+    return Result;
+  });
+}
+
 bool ReplaceOpenCLBuiltinPass::replacePrefetch(Function &F) {
   bool Changed = false;
 
@@ -1619,9 +2061,17 @@ bool ReplaceOpenCLBuiltinPass::replaceVstore(Function &F) {
     if (pointee_type != vec_data_type->getElementType())
       return V;
 
+    IRBuilder<> builder(CI);
+
+    // If the pointer is known to point at vectors of the data type, store the
+    // whole vector at once.
+    if (auto vec_ptr = GetVectorBasePointer(ptr, vec_data_type)) {
+      auto gep = builder.CreateGEP(vec_ptr, offset);
+      return builder.CreateStore(data, gep);
+    }
+
     // Avoid pointer casts. Instead generate the correct number of stores
     // and rely on drivers to coalesce appropriately.
-    IRBuilder<> builder(CI);
     auto elems_const = builder.getInt32(elems);
     auto adjust = builder.CreateMul(offset, elems_const);
     for (size_t i = 0; i < elems; ++i) {
@@ -1655,9 +2105,17 @@ bool ReplaceOpenCLBuiltinPass::replaceVload(Function &F) {
     if (pointee_type != vec_ret_type->getElementType())
       return V;
 
+    IRBuilder<> builder(CI);
+
+    // If the pointer is known to point at vectors of the result type, load
+    // the whole vector at once.
+    if (auto vec_ptr = GetVectorBasePointer(ptr, vec_ret_type)) {
+      auto gep = builder.CreateGEP(vec_ptr, offset);
+      return builder.CreateLoad(gep);
+    }
+
     // Avoid pointer casts. Instead generate the correct number of loads
     // and rely on drivers to coalesce appropriately.
-    IRBuilder<> builder(CI);
     auto elems_const = builder.getInt32(elems);
     V = UndefValue::get(ret_type);
     auto adjust = builder.CreateMul(offset, elems_const);
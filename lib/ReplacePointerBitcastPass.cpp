@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include "llvm/ADT/Statistic.h"
 #include "llvm/IR/DataLayout.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/Instructions.h"
@@ -26,6 +27,10 @@ using namespace llvm;
 
 #define DEBUG_TYPE "replacepointerbitcast"
 
+STATISTIC(NumMemOps, "Number of loads and stores generated");
+STATISTIC(NumMemOpsSaved,
+          "Number of memory operations saved over per-element access");
+
 namespace {
 struct ReplacePointerBitcastPass : public ModulePass {
   static char ID;
@@ -234,6 +239,106 @@ Value *ConvertValue(Value *src, Type *dst_type, IRBuilder<> &builder) {
   return nullptr;
 }
 
+// Returns true if an access of |dst_type| on memory of the narrower vector
+// type |src_type| is better expressed by reinterpreting each |src_type| chunk
+// as a single integer than by shuffling elements. Both forms issue one memory
+// operation per chunk, so the choice is made on instruction count, but the
+// shuffle form is only legal when it never needs vectors of more than four
+// components and, for stores, when the element widths match.
+bool PreferWholeChunks(Type *src_type, Type *dst_type, bool is_store,
+                       const DataLayout &DL) {
+  auto *src_vec_type = dyn_cast<FixedVectorType>(src_type);
+  if (!src_vec_type)
+    return false;
+
+  unsigned src_bits = DL.getTypeStoreSizeInBits(src_type);
+  unsigned dst_bits = DL.getTypeStoreSizeInBits(dst_type);
+  if (src_bits >= dst_bits || dst_bits % src_bits)
+    return false;
+  unsigned num_chunks = dst_bits / src_bits;
+
+  // Each chunk becomes one component of an integer vector.
+  bool chunks_legal = num_chunks <= 4 && (src_bits == 8 || src_bits == 16 ||
+                                          src_bits == 32 || src_bits == 64);
+  if (!chunks_legal)
+    return false;
+  // Bitcast and insert (or extract) per chunk, plus the final bitcast.
+  unsigned chunks_cost = 2 * num_chunks + 1;
+
+  unsigned src_ele_bits =
+      DL.getTypeStoreSizeInBits(src_vec_type->getElementType());
+  bool shuffle_legal;
+  unsigned shuffle_cost;
+  if (is_store) {
+    auto *dst_vec_type = dyn_cast<VectorType>(dst_type);
+    shuffle_legal = dst_vec_type &&
+                    DL.getTypeStoreSizeInBits(
+                        dst_vec_type->getElementType()) == src_ele_bits;
+    // One bitcast, then one shuffle per chunk.
+    shuffle_cost = num_chunks + 1;
+  } else {
+    shuffle_legal = src_vec_type->getNumElements() * num_chunks <= 4;
+    // A tree of shuffles, then one bitcast.
+    shuffle_cost = num_chunks;
+  }
+
+  return !shuffle_legal || chunks_cost < shuffle_cost;
+}
+
+// Assembles a value of |dst_type| from |chunks| by reinterpreting each chunk
+// as an integer of the same width.
+Value *BuildFromChunks(ArrayRef<Value *> chunks, Type *dst_type,
+                       IRBuilder<> &builder) {
+  auto *module = builder.GetInsertBlock()->getParent()->getParent();
+  auto &DL = module->getDataLayout();
+  auto *chunk_type =
+      builder.getIntNTy(DL.getTypeStoreSizeInBits(chunks[0]->getType()));
+  Value *result =
+      UndefValue::get(FixedVectorType::get(chunk_type, chunks.size()));
+  for (unsigned i = 0; i < chunks.size(); i++) {
+    auto *chunk = builder.CreateBitCast(chunks[i], chunk_type);
+    result = builder.CreateInsertElement(result, chunk, builder.getInt32(i));
+  }
+  return builder.CreateBitCast(result, dst_type);
+}
+
+// Splits |v| into |num_chunks| values of |chunk_type|, the inverse of
+// BuildFromChunks.
+void SplitIntoChunks(Value *v, Type *chunk_type, unsigned num_chunks,
+                     SmallVectorImpl<Value *> *chunks, IRBuilder<> &builder) {
+  auto *module = builder.GetInsertBlock()->getParent()->getParent();
+  auto &DL = module->getDataLayout();
+  auto *int_type = builder.getIntNTy(DL.getTypeStoreSizeInBits(chunk_type));
+  auto *vec = builder.CreateBitCast(
+      v, FixedVectorType::get(int_type, num_chunks));
+  for (unsigned i = 0; i < num_chunks; i++) {
+    auto *chunk = builder.CreateExtractElement(vec, builder.getInt32(i));
+    chunks->push_back(builder.CreateBitCast(chunk, chunk_type));
+  }
+}
+
+// Updates the memory operation statistics for the replacement of |I|, an
+// access of |access_type| on memory whose scalar elements are |src_ele_type|.
+// The replacement occupies the instructions between |prev| (the instruction
+// that preceded |I| beforehand, or null) and |I|. The saving is measured
+// against accessing every scalar element individually.
+void RecordMemoryOps(Instruction *prev, Instruction *I, Type *access_type,
+                     Type *src_ele_type, const DataLayout &DL) {
+  auto begin =
+      prev ? std::next(prev->getIterator()) : I->getParent()->begin();
+  unsigned emitted = 0;
+  for (auto iter = begin; &*iter != I; ++iter) {
+    if (isa<LoadInst>(*iter) || isa<StoreInst>(*iter))
+      ++emitted;
+  }
+  NumMemOps += emitted;
+
+  unsigned ele_bits = DL.getTypeStoreSizeInBits(src_ele_type->getScalarType());
+  unsigned scalarized = DL.getTypeStoreSizeInBits(access_type) / ele_bits;
+  if (scalarized > emitted)
+    NumMemOpsSaved += scalarized - emitted;
+}
+
 } // namespace
 
 unsigned ReplacePointerBitcastPass::CalculateNumIter(unsigned SrcTyBitWidth,
@@ -435,9 +540,43 @@ bool ReplacePointerBitcastPass::runOnModule(Module &M) {
         IsGEPUser = UserIter.second;
 
         IRBuilder<> Builder(cast<Instruction>(U));
+        Instruction *Prev = cast<Instruction>(U)->getPrevNode();
 
         if (StoreInst *ST = dyn_cast<StoreInst>(U)) {
-          if (SrcTyBitWidth < DstTyBitWidth) {
+          if (SrcTyBitWidth < DstTyBitWidth &&
+              PreferWholeChunks(SrcTy, DstTy, true, DL)) {
+            //
+            // Consider below case.
+            //
+            // Original IR (char4* --> int4*)
+            // 1. dst_addr = bitcast char4*, int4*
+            // 2. dst_addr = gep (int4*) dst_addr, idx
+            // 3. store (int4) val, (int4*) dst_addr
+            //
+            // Transformed IR: Reinterpret the value as one integer per
+            // destination chunk, so no vector wider than four components is
+            // required.
+            // 1. tmp_val(<4 x i32>) = bitcast (int4) val
+            // 2. val1(i32) = extractelement tmp_val, 0
+            // 3. val1(char4) = bitcast val1
+            // ...
+            // 4. dst_addr1 = gep (char4*) dst_addr, idx * 4
+            // 5. store (char4) val1, (char4*) dst_addr1
+            // ...
+            //
+            SmallVector<Value *, 4> STValues;
+            SplitIntoChunks(ST->getValueOperand(), SrcTy, NumIter, &STValues,
+                            Builder);
+
+            Value *SrcAddrIdx = NewAddrIdx;
+            for (unsigned i = 0; i < STValues.size(); i++) {
+              if (i > 0) {
+                SrcAddrIdx = Builder.CreateAdd(SrcAddrIdx, Builder.getInt32(1));
+              }
+              Value *DstAddr = Builder.CreateGEP(BitCastSrc, SrcAddrIdx);
+              Builder.CreateStore(STValues[i], DstAddr);
+            }
+          } else if (SrcTyBitWidth < DstTyBitWidth) {
             //
             // Consider below case.
             //
@@ -815,6 +954,25 @@ bool ReplacePointerBitcastPass::runOnModule(Module &M) {
                 llvm_unreachable("Handle this bitcast");
               }
             }
+          } else if (SrcTyBitWidth < DstTyBitWidth &&
+                     PreferWholeChunks(SrcTy, DstTy, false, DL)) {
+            //
+            // Consider below case.
+            //
+            // Original IR (char4* --> int4*)
+            // 1. src_addr = bitcast char4*, int4*
+            // 2. element_addr = gep (int4*) src_addr, idx
+            // 3. load (int4*) element_addr
+            //
+            // Transformed IR
+            // 1. src_addr = gep (char4*) src, idx * 4
+            // 2. src_val1(char4) = load (char4*) src_addr
+            // ...
+            // 3. tmp_val(<4 x i32>) = insertelement undef, (i32)src_val1, 0
+            // ...
+            // 4. dst_val(int4) = bitcast tmp_val, (int4)
+            //
+            DstVal = BuildFromChunks(LDValues, DstTy, Builder);
           } else if (SrcTyBitWidth < DstTyBitWidth) {
             //
             // Consider below case.
@@ -963,6 +1121,10 @@ bool ReplacePointerBitcastPass::runOnModule(Module &M) {
               "Handle above user of gep on ReplacePointerBitcastPass");
         }
 
+        Type *AccessTy = isa<StoreInst>(U)
+                             ? cast<StoreInst>(U)->getValueOperand()->getType()
+                             : U->getType();
+        RecordMemoryOps(Prev, cast<Instruction>(U), AccessTy, SrcEleTy, DL);
         ToBeDeleted.push_back(cast<Instruction>(U));
       }
 
@@ -1093,6 +1255,7 @@ bool ReplacePointerBitcastPass::runOnModule(Module &M) {
         IsGEPUser = UserIter.second;
 
         IRBuilder<> Builder(cast<Instruction>(U));
+        Instruction *Prev = cast<Instruction>(U)->getPrevNode();
 
         // Handle store instruction with gep.
         if (StoreInst *ST = dyn_cast<StoreInst>(U)) {
@@ -1184,6 +1347,10 @@ bool ReplacePointerBitcastPass::runOnModule(Module &M) {
                            "ReplacePointerBitcastPass");
         }
 
+        Type *AccessTy = isa<StoreInst>(U)
+                             ? cast<StoreInst>(U)->getValueOperand()->getType()
+                             : U->getType();
+        RecordMemoryOps(Prev, cast<Instruction>(U), AccessTy, SrcTy, DL);
         ToBeDeleted.push_back(cast<Instruction>(U));
       }
 
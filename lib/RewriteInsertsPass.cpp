@@ -17,6 +17,7 @@
 
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/ADT/UniqueVector.h"
 #include "llvm/IR/Attributes.h"
 #include "llvm/IR/Constants.h"
@@ -37,6 +38,11 @@ using std::string;
 
 #define DEBUG_TYPE "rewriteinserts"
 
+STATISTIC(NumHackInsertsInstructionsAdded,
+          "Number of instructions added by -hack-inserts");
+STATISTIC(NumHackInsertsInstructionsRemoved,
+          "Number of instructions removed by -hack-inserts");
+
 namespace {
 
 class RewriteInsertsPass : public ModulePass {
@@ -265,7 +271,17 @@ bool RewriteInsertsPass::runOnModule(Module &M) {
   bool Changed = ReplaceCompleteInsertionChains(M);
 
   if (clspv::Option::HackInserts()) {
+    const unsigned NumInstructions = M.getInstructionCount();
     Changed |= ReplacePartialInsertions(M);
+    // Constructing a whole chain at once can take fewer instructions than the
+    // insertions it replaces, so the difference is signed.
+    const int64_t Delta =
+        int64_t(M.getInstructionCount()) - int64_t(NumInstructions);
+    if (Delta > 0) {
+      NumHackInsertsInstructionsAdded += Delta;
+    } else {
+      NumHackInsertsInstructionsRemoved += -Delta;
+    }
   }
 
   return Changed;
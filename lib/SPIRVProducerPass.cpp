@@ -28,10 +28,14 @@
 #include <unordered_set>
 #include <utility>
 
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/ADT/UniqueVector.h"
 #include "llvm/Analysis/LoopInfo.h"
 #include "llvm/IR/Constants.h"
+#include "llvm/IR/DebugInfoMetadata.h"
 #include "llvm/IR/Dominators.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/Intrinsics.h"
@@ -40,8 +44,10 @@
 #include "llvm/IR/ValueSymbolTable.h"
 #include "llvm/Pass.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MathExtras.h"
+#include "llvm/Support/Path.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Transforms/Utils/Cloning.h"
 
@@ -64,6 +70,7 @@
 #include "Constants.h"
 #include "DescriptorCounter.h"
 #include "Layout.h"
+#include "MemoryAccess.h"
 #include "NormalizeGlobalVariable.h"
 #include "Passes.h"
 #include "SpecConstant.h"
@@ -79,6 +86,11 @@ using namespace clspv::Builtins;
 using namespace clspv::Option;
 using namespace mdconst;
 
+#define DEBUG_TYPE "spirvproducer"
+
+STATISTIC(NumHackInitializersInstructions,
+          "Number of instructions added by -hack-initializers");
+
 namespace {
 
 cl::opt<std::string> TestOutFile("producer-out-file", cl::init("test.spv"),
@@ -88,6 +100,10 @@ cl::opt<std::string> TestOutFile("producer-out-file", cl::init("test.spv"),
 cl::opt<bool> ShowResourceVars("show-rv", cl::init(false), cl::Hidden,
                                cl::desc("Show resource variable creation"));
 
+cl::opt<bool> CompactIDs(
+    "compact-ids", cl::init(true), cl::Hidden,
+    cl::desc("Renumber SPIR-V IDs densely in order of first appearance"));
+
 cl::opt<bool>
     ShowProducerIR("show-producer-ir", cl::init(false), cl::ReallyHidden,
                    cl::desc("Dump the IR at the start of SPIRVProducer"));
@@ -160,6 +176,10 @@ struct SPIRVOperand {
 
   SPIRVOperandType getType() const { return Type; }
   uint32_t getNumID() const { return LiteralNum[0]; }
+  void setNumID(uint32_t ID) {
+    assert(Type == NUMBERID);
+    LiteralNum[0] = ID;
+  }
   std::string getLiteralStr() const { return LiteralStr; }
   const uint32_t *getLiteralNum() const { return LiteralNum; }
 
@@ -210,6 +230,14 @@ struct SPIRVInstruction {
   uint16_t getOpcode() const { return Opcode; }
   SPIRVID getResultID() const { return ResultID; }
   const SPIRVOperandVec &getOperands() const { return Operands; }
+  SPIRVOperandVec &getOperands() { return Operands; }
+
+  // Replaces the result ID. The word count is unchanged, so the instruction
+  // must already have a result.
+  void setResultID(SPIRVID ResID) {
+    assert(ResultID.isValid() && ResID.isValid());
+    ResultID = ResID;
+  }
 
 private:
   void setResult(SPIRVID ResID = 0) {
@@ -254,26 +282,37 @@ struct SPIRVProducerPass final : public ModulePass {
 
   SPIRVProducerPass(
       raw_pwrite_stream *out,
-      SmallVectorImpl<std::pair<unsigned, std::string>> *samplerMap,
-      bool outputCInitList)
+      SmallVectorImpl<std::pair<unsigned, std::string>> *samplerMap)
       : ModulePass(ID), module(nullptr), samplerMap(samplerMap), out(out),
-        binaryTempOut(binaryTempUnderlyingVector), binaryOut(out),
-        outputCInitList(outputCInitList), patchBoundOffset(0), nextID(1),
+        binaryOut(out), patchBoundOffset(0), nextID(1),
         OpExtInstImportID(0), HasVariablePointersStorageBuffer(false),
         HasVariablePointers(false), SamplerTy(nullptr), WorkgroupSizeValueID(0),
-        WorkgroupSizeVarID(0), TestOutput(false) {
+        WorkgroupSizeVarID(0), TestOutput(false),
+        CoherentScope(spv::ScopeWorkgroup) {
     addCapability(spv::CapabilityShader);
+    if (clspv::Option::PhysicalStorageBuffers()) {
+      addCapability(spv::CapabilityPhysicalStorageBufferAddresses);
+    }
+    if (clspv::Option::VulkanMemoryModel()) {
+      addCapability(spv::CapabilityVulkanMemoryModel);
+    }
     Ptr = this;
   }
 
   SPIRVProducerPass()
       : ModulePass(ID), module(nullptr), samplerMap(nullptr), out(nullptr),
-        binaryTempOut(binaryTempUnderlyingVector), binaryOut(nullptr),
-        outputCInitList(false), patchBoundOffset(0), nextID(1),
+        binaryOut(nullptr), patchBoundOffset(0), nextID(1),
         OpExtInstImportID(0), HasVariablePointersStorageBuffer(false),
         HasVariablePointers(false), SamplerTy(nullptr), WorkgroupSizeValueID(0),
-        WorkgroupSizeVarID(0), TestOutput(true) {
+        WorkgroupSizeVarID(0), TestOutput(true),
+        CoherentScope(spv::ScopeWorkgroup) {
     addCapability(spv::CapabilityShader);
+    if (clspv::Option::PhysicalStorageBuffers()) {
+      addCapability(spv::CapabilityPhysicalStorageBufferAddresses);
+    }
+    if (clspv::Option::VulkanMemoryModel()) {
+      addCapability(spv::CapabilityVulkanMemoryModel);
+    }
     Ptr = this;
   }
 
@@ -344,6 +383,9 @@ struct SPIRVProducerPass final : public ModulePass {
   void FindResourceVars();
   void FindTypesForSamplerMap();
   void FindTypesForResourceVars();
+  // Sets |CoherentScope| to the widest memory scope of the barriers, fences
+  // and atomics ordering global memory.
+  void FindCoherentScope();
 
   // Returns the canonical type of |type|.
   //
@@ -363,7 +405,8 @@ struct SPIRVProducerPass final : public ModulePass {
 
   bool PointerRequiresLayout(unsigned aspace);
 
-  SPIRVID getSPIRVBuiltin(spv::BuiltIn BID, spv::Capability Cap);
+  SPIRVID getSPIRVBuiltin(spv::BuiltIn BID, spv::Capability Cap,
+                          Type *Ty = nullptr);
 
   void GenerateModuleInfo();
   void GenerateGlobalVar(GlobalVariable &GV);
@@ -388,6 +431,9 @@ struct SPIRVProducerPass final : public ModulePass {
                                       const FunctionInfo &FuncInfo);
   SPIRVID GenerateInstructionFromCall(CallInst *Call);
   void GenerateInstruction(Instruction &I);
+  // Emits an OpLine for the debug location of |I| if it differs from the
+  // previous one in the current block.
+  void GenerateDebugLine(Instruction &I);
   void GenerateFuncEpilogue();
   void HandleDeferredInstruction();
   void HandleDeferredDecorations();
@@ -414,6 +460,17 @@ struct SPIRVProducerPass final : public ModulePass {
   void WriteSPIRVBinary();
   void WriteSPIRVBinary(SPIRVInstructionList &SPIRVInstList);
 
+  // Creates the temporary file that finished functions are streamed to.
+  void OpenFunctionSpillFile();
+  // Writes the finished functions to the spill file and releases them.
+  void SpillFunctions();
+  // Copies the spilled functions into the output and removes the spill file.
+  void WriteSpilledFunctions();
+
+  // Renumbers all IDs densely in the order they first appear in the module
+  // and resets |nextID| to the resulting minimal bound.
+  void CompactSPIRVIDs();
+
   // Returns true if |type| is compatible with OpConstantNull.
   bool IsTypeNullable(const Type *type) const;
 
@@ -437,10 +494,21 @@ struct SPIRVProducerPass final : public ModulePass {
   // Add Capability if not already (e.g. CapabilityGroupNonUniformBroadcast)
   void addCapability(uint32_t c) { CapabilitySet.emplace(c); }
 
+  // Add Extension if not already present.
+  void addExtension(const std::string &e) { ExtensionSet.emplace(e); }
+
   // Sets |HasVariablePointersStorageBuffer| or |HasVariablePointers| base on
   // |address_space|.
   void setVariablePointersCapabilities(unsigned address_space);
 
+  // Returns true if |type| is a pointer in the PhysicalStorageBuffer storage
+  // class.
+  bool IsPhysicalPointer(Type *type) const {
+    return type->isPointerTy() &&
+           GetStorageClass(type->getPointerAddressSpace()) ==
+               spv::StorageClassPhysicalStorageBuffer;
+  }
+
   // Returns true if |lhs| and |rhs| represent the same resource or workgroup
   // variable.
   bool sameResource(Value *lhs, Value *rhs) const;
@@ -452,6 +520,40 @@ struct SPIRVProducerPass final : public ModulePass {
   // Returns true if |Arg| is called with a coherent resource.
   bool CalledWithCoherentResource(Argument &Arg);
 
+  // Returns true if |ptr| may point into a coherent resource.
+  bool PointsToCoherentResource(Value *ptr);
+
+  // Returns the ID of the scope constant |scope|.
+  SPIRVID getSPIRVScope(uint32_t scope);
+
+  // Returns |semantics| adjusted for the Vulkan memory model: sequential
+  // consistency becomes the strongest ordering |opcode| allows, acquires make
+  // memory visible and releases make it available. |unequal| selects the
+  // semantics of a failed compare-exchange.
+  uint32_t getVulkanMemorySemantics(spv::Op opcode, uint32_t semantics,
+                                    bool unequal) const;
+
+  // Appends |V|, operand |index| of the barrier or atomic |opcode|, to |Ops|.
+  // Constant scopes and memory semantics are adjusted for the Vulkan memory
+  // model.
+  void addSyncOperand(SPIRVOperandVec &Ops, spv::Op opcode, unsigned index,
+                      Value *V);
+
+  // Returns the memory operand mask of an access through |ptr| required by
+  // the Vulkan memory model, if any.
+  uint32_t getNonPrivateMemoryAccess(Value *ptr) const;
+
+  // Appends the optional memory operands of a load (or store if |is_store|)
+  // of |align| bytes through |ptr| to |Ops|.
+  void addMemoryAccessOperands(SPIRVOperandVec &Ops, Value *ptr,
+                               uint64_t align, bool is_store);
+
+  // Appends the image operands |mask| of a read (or write if |is_write|) of
+  // the storage image |image| to |Ops|, along with those required by the
+  // Vulkan memory model.
+  void addImageAccessOperands(SPIRVOperandVec &Ops, Value *image,
+                              uint32_t mask, bool is_write);
+
   //
   // Primary interface for adding SPIRVInstructions to a SPIRVSection.
   template <enum SPIRVSection TSection = kFunctions>
@@ -525,26 +627,25 @@ private:
   // Set of Capabilities required
   CapabilitySetType CapabilitySet;
 
+  // Set of Extensions required beyond those implied by the SPIR-V version.
+  std::set<std::string> ExtensionSet;
+
   // Map from clspv::BuiltinType to SPIRV Global Variable
   BuiltinConstantMapType BuiltinConstantMap;
 
   SmallVectorImpl<std::pair<unsigned, std::string>> *samplerMap;
   raw_pwrite_stream *out;
 
-  // TODO(dneto): Wouldn't it be better to always just emit a binary, and then
-  // convert to other formats on demand?
-
-  // When emitting a C initialization list, the WriteSPIRVBinary method
-  // will actually write its words to this vector via binaryTempOut.
-  SmallVector<char, 100> binaryTempUnderlyingVector;
-  raw_svector_ostream binaryTempOut;
-
-  // Binary output writes to this stream, which might be |out| or
-  // |binaryTempOut|.  It's the latter when we really want to write a C
-  // initializer list.
+  // Binary output writes to this stream. Other output formats are derived
+  // from the binary by the caller.
   raw_pwrite_stream *binaryOut;
-  const bool outputCInitList; // If true, output look like {0x7023, ... , 5}
   uint64_t patchBoundOffset;
+
+  // When streaming functions, each finished function is written to this file
+  // and the whole file is copied into the output after the module-level
+  // sections have been written.
+  std::unique_ptr<raw_fd_ostream> FunctionSpillOut;
+  SmallString<128> FunctionSpillPath;
   uint32_t nextID;
 
   SPIRVID incrNextID() { return nextID++; }
@@ -601,6 +702,10 @@ private:
 
   bool TestOutput;
 
+  // The scope at which accesses to coherent resources are made available and
+  // visible under the Vulkan memory model.
+  spv::Scope CoherentScope;
+
   // Bookkeeping for mapping kernel arguments to resource variables.
   struct ResourceVarInfo {
     ResourceVarInfo(int index_arg, unsigned set_arg, unsigned binding_arg,
@@ -617,6 +722,12 @@ private:
     const unsigned addr_space; // The LLVM address space
     // The SPIR-V ID of the OpVariable.  Not populated at construction time.
     SPIRVID var_id;
+    // Whether any kernel reads or writes the variable.
+    bool reads = false;
+    bool writes = false;
+    // Whether every kernel argument mapped to the variable is restrict
+    // qualified.
+    bool restrict_qualified = true;
   };
   // A list of resource var info.  Each one correponds to a module-scope
   // resource variable we will have to create.  Resource var indices are
@@ -677,6 +788,11 @@ private:
   SPIRVID ReflectionID;
   DenseMap<Function *, SPIRVID> KernelDeclarations;
 
+  // Maps a source file name to the OpString holding it.
+  StringMap<SPIRVID> DebugFileStrings;
+  // The file, line and column of the last OpLine in the current block.
+  std::tuple<uint32_t, uint32_t, uint32_t> LastDebugLine;
+
 public:
   static SPIRVProducerPass *Ptr;
 };
@@ -691,9 +807,8 @@ INITIALIZE_PASS(SPIRVProducerPass, "SPIRVProducerPass", "SPIR-V output pass",
 namespace clspv {
 ModulePass *createSPIRVProducerPass(
     raw_pwrite_stream *out,
-    SmallVectorImpl<std::pair<unsigned, std::string>> *samplerMap,
-    bool outputCInitList) {
-  return new SPIRVProducerPass(out, samplerMap, outputCInitList);
+    SmallVectorImpl<std::pair<unsigned, std::string>> *samplerMap) {
+  return new SPIRVProducerPass(out, samplerMap);
 }
 
 ModulePass *createSPIRVProducerPass() { return new SPIRVProducerPass(); }
@@ -752,7 +867,7 @@ bool SPIRVProducerPass::runOnModule(Module &M) {
     out = new raw_svector_ostream(*binary);
   }
 
-  binaryOut = outputCInitList ? &binaryTempOut : out;
+  binaryOut = out;
 
   PopulateUBOTypeMaps();
   PopulateStructuredCFGMaps();
@@ -784,6 +899,18 @@ bool SPIRVProducerPass::runOnModule(Module &M) {
   GenerateResourceVars();
   GenerateWorkgroupVars();
 
+  const bool stream_functions = clspv::Option::StreamFunctions();
+  if (stream_functions) {
+    // Reserve all function IDs up front so that calls to functions defined
+    // later in the module can be resolved as soon as the caller is complete.
+    for (Function &F : *module) {
+      if (!F.isDeclaration()) {
+        ValueMap[&F] = incrNextID();
+      }
+    }
+    OpenFunctionSpillFile();
+  }
+
   // Generate SPIRV instructions for each function.
   for (Function &F : *module) {
     if (F.isDeclaration()) {
@@ -798,6 +925,13 @@ bool SPIRVProducerPass::runOnModule(Module &M) {
 
     // Generate Function Epilogue.
     GenerateFuncEpilogue();
+
+    if (stream_functions) {
+      // Deferred instructions only refer to values in the same function, to
+      // constants or to function IDs, so the function is complete now.
+      HandleDeferredInstruction();
+      SpillFunctions();
+    }
   }
 
   HandleDeferredInstruction();
@@ -809,35 +943,16 @@ bool SPIRVProducerPass::runOnModule(Module &M) {
   // Generate embedded reflection information.
   GenerateReflection();
 
+  // Spilled functions have already been written with their final IDs.
+  if (CompactIDs && !stream_functions) {
+    CompactSPIRVIDs();
+  }
+
   WriteSPIRVBinary();
 
   // We need to patch the SPIR-V header to set bound correctly.
   patchHeader();
 
-  if (outputCInitList) {
-    bool first = true;
-    std::ostringstream os;
-
-    auto emit_word = [&os, &first](uint32_t word) {
-      if (!first)
-        os << ",\n";
-      os << word;
-      first = false;
-    };
-
-    os << "{";
-    const std::string str(binaryTempOut.str());
-    for (unsigned i = 0; i < str.size(); i += 4) {
-      const uint32_t a = static_cast<unsigned char>(str[i]);
-      const uint32_t b = static_cast<unsigned char>(str[i + 1]);
-      const uint32_t c = static_cast<unsigned char>(str[i + 2]);
-      const uint32_t d = static_cast<unsigned char>(str[i + 3]);
-      emit_word(a | (b << 8) | (c << 16) | (d << 24));
-    }
-    os << "}\n";
-    *out << os.str();
-  }
-
   if (TestOutput) {
     std::error_code error;
     raw_fd_ostream test_output(TestOutFile, error, llvm::sys::fs::FA_Write);
@@ -906,6 +1021,10 @@ void SPIRVProducerPass::GenerateLLVMIRInfo() {
 
   FindTypesForSamplerMap();
   FindTypesForResourceVars();
+
+  if (clspv::Option::VulkanMemoryModel()) {
+    FindCoherentScope();
+  }
 }
 
 void SPIRVProducerPass::FindGlobalConstVars() {
@@ -1078,6 +1197,22 @@ void SPIRVProducerPass::FindResourceVars() {
             }
           }
 
+          // Accumulate the accesses of every kernel using the variable.
+          bool reads = false;
+          bool writes = false;
+          std::tie(reads, writes) = clspv::HasReadsAndWrites(call);
+          rv->reads |= reads;
+          rv->writes |= writes;
+
+          // The kernel arguments are still present. Helper functions that
+          // access the resource directly do not have a matching argument.
+          auto *func = call->getParent()->getParent();
+          if (func->getCallingConv() == CallingConv::SPIR_KERNEL &&
+              arg_index < func->arg_size() &&
+              !func->hasParamAttribute(arg_index, Attribute::NoAlias)) {
+            rv->restrict_qualified = false;
+          }
+
           // Now populate FunctionToResourceVarsMap.
           auto &mapping =
               FunctionToResourceVarsMap[call->getParent()->getParent()];
@@ -1195,6 +1330,29 @@ void SPIRVProducerPass::FindTypesForResourceVars() {
   // mark them as needing layout.
   std::vector<Type *> work_list(StructTypesNeedingBlock.begin(),
                                 StructTypesNeedingBlock.end());
+
+  // Memory accessed through physical pointers is explicitly laid out too.
+  if (clspv::Option::PhysicalStorageBuffers()) {
+    DenseSet<Type *> seen;
+    auto AddPointee = [this, &seen, &work_list](Type *type) {
+      if (IsPhysicalPointer(type) && seen.insert(type).second) {
+        work_list.push_back(type->getPointerElementType());
+      }
+    };
+    for (Function &F : *module) {
+      for (Argument &Arg : F.args()) {
+        AddPointee(Arg.getType());
+      }
+      for (BasicBlock &BB : F) {
+        for (Instruction &I : BB) {
+          AddPointee(I.getType());
+          for (auto &Op : I.operands()) {
+            AddPointee(Op->getType());
+          }
+        }
+      }
+    }
+  }
   while (!work_list.empty()) {
     Type *type = work_list.back();
     work_list.pop_back();
@@ -1286,7 +1444,9 @@ spv::StorageClass SPIRVProducerPass::GetStorageClass(unsigned AddrSpace) const {
   case AddressSpace::Private:
     return spv::StorageClassFunction;
   case AddressSpace::Global:
-    return spv::StorageClassStorageBuffer;
+    return clspv::Option::PhysicalStorageBuffers()
+               ? spv::StorageClassPhysicalStorageBuffer
+               : spv::StorageClassStorageBuffer;
   case AddressSpace::Constant:
     return clspv::Option::ConstantArgsInUniformBuffer()
                ? spv::StorageClassUniform
@@ -1386,11 +1546,12 @@ Type *SPIRVProducerPass::CanonicalType(Type *type) {
     switch (type->getTypeID()) {
     case Type::PointerTyID: {
       // For the purposes of our Vulkan SPIR-V type system, constant and global
-      // are conflated.
+      // are conflated unless global memory is physically addressed.
       auto *ptr_ty = cast<PointerType>(type);
       unsigned AddrSpace = ptr_ty->getAddressSpace();
       if (AddressSpace::Constant == AddrSpace) {
-        if (!clspv::Option::ConstantArgsInUniformBuffer()) {
+        if (!clspv::Option::ConstantArgsInUniformBuffer() &&
+            !clspv::Option::PhysicalStorageBuffers()) {
           AddrSpace = AddressSpace::Global;
           // The canonical type of __constant is __global unless constants are
           // passed in uniform buffers.
@@ -2277,8 +2438,9 @@ void SPIRVProducerPass::GenerateResourceVars() {
     Ops << info->var_id << spv::DecorationBinding << info->binding;
     addSPIRVInst<kAnnotations>(spv::OpDecorate, Ops);
 
-    if (info->coherent) {
-      // Decorate with Coherent if required for the variable.
+    if (info->coherent && !clspv::Option::VulkanMemoryModel()) {
+      // Decorate with Coherent if required for the variable. The Vulkan
+      // memory model expresses coherence on each access instead.
       Ops.clear();
       Ops << info->var_id << spv::DecorationCoherent;
       addSPIRVInst<kAnnotations>(spv::OpDecorate, Ops);
@@ -2288,11 +2450,25 @@ void SPIRVProducerPass::GenerateResourceVars() {
     switch (info->arg_kind) {
     case clspv::ArgKind::Buffer:
     case clspv::ArgKind::BufferUBO:
-      if (info->var_fn->getReturnType()->getPointerAddressSpace() ==
-          clspv::AddressSpace::Constant) {
+    case clspv::ArgKind::Pod:
+      // Buffers that are never written allow drivers to use cached loads.
+      if (info->addr_space == clspv::AddressSpace::Constant || !info->writes) {
         Ops.clear();
         Ops << info->var_id << spv::DecorationNonWritable;
         addSPIRVInst<kAnnotations>(spv::OpDecorate, Ops);
+      } else if (!info->reads) {
+        Ops.clear();
+        Ops << info->var_id << spv::DecorationNonReadable;
+        addSPIRVInst<kAnnotations>(spv::OpDecorate, Ops);
+      }
+
+      // Restrict qualified buffers are the only way their memory is
+      // accessed.
+      if (info->arg_kind == clspv::ArgKind::Buffer &&
+          info->restrict_qualified) {
+        Ops.clear();
+        Ops << info->var_id << spv::DecorationRestrict;
+        addSPIRVInst<kAnnotations>(spv::OpDecorate, Ops);
       }
       break;
     case clspv::ArgKind::StorageImage: {
@@ -2661,9 +2837,17 @@ void SPIRVProducerPass::GenerateFuncPrologue(Function &F) {
 
   FOps << FTyID;
 
-  // Generate SPIRV instruction for function.
-  SPIRVID FID = addSPIRVInst(spv::OpFunction, FOps);
-  VMap[&F] = FID;
+  // Generate SPIRV instruction for function. The ID may have been reserved
+  // already when streaming functions.
+  SPIRVID FID;
+  auto where = VMap.find(&F);
+  if (where != VMap.end()) {
+    FID = where->second;
+    SPIRVSections[kFunctions].emplace_back(spv::OpFunction, FID, FOps);
+  } else {
+    FID = addSPIRVInst(spv::OpFunction, FOps);
+    VMap[&F] = FID;
+  }
 
   if (F.getCallingConv() == CallingConv::SPIR_KERNEL) {
     EntryPoints.push_back(std::make_pair(&F, FID));
@@ -2703,7 +2887,8 @@ void SPIRVProducerPass::GenerateFuncPrologue(Function &F) {
       SPIRVID param_id = addSPIRVInst(spv::OpFunctionParameter, Ops);
       VMap[&Arg] = param_id;
 
-      if (CalledWithCoherentResource(Arg)) {
+      if (!clspv::Option::VulkanMemoryModel() &&
+          CalledWithCoherentResource(Arg)) {
         // If the arg is passed a coherent resource ever, then decorate this
         // parameter with Coherent too.
         Ops.clear();
@@ -2711,6 +2896,13 @@ void SPIRVProducerPass::GenerateFuncPrologue(Function &F) {
         addSPIRVInst<kAnnotations>(spv::OpDecorate, Ops);
       }
 
+      if (IsPhysicalPointer(Arg.getType())) {
+        // Physical pointer parameters must declare whether they alias.
+        Ops.clear();
+        Ops << param_id << spv::DecorationAliased;
+        addSPIRVInst<kAnnotations>(spv::OpDecorate, Ops);
+      }
+
       ArgIdx++;
     }
   }
@@ -2752,15 +2944,37 @@ void SPIRVProducerPass::GenerateModuleInfo() {
     }
   }
 
+  // Physical storage buffers were made core in SPIR-V 1.5.
+  if (clspv::Option::PhysicalStorageBuffers() &&
+      SpvVersion() < SPIRVVersion::SPIRV_1_5) {
+    addSPIRVInst<kExtensions>(spv::OpExtension,
+                              "SPV_KHR_physical_storage_buffer");
+  }
+
+  // The Vulkan memory model was made core in SPIR-V 1.5.
+  if (clspv::Option::VulkanMemoryModel() &&
+      SpvVersion() < SPIRVVersion::SPIRV_1_5) {
+    addSPIRVInst<kExtensions>(spv::OpExtension, "SPV_KHR_vulkan_memory_model");
+  }
+
+  for (auto &Extension : ExtensionSet) {
+    addSPIRVInst<kExtensions>(spv::OpExtension, Extension.c_str());
+  }
+
   //
   // Generate OpMemoryModel
   //
-  // Memory model for Vulkan will always be GLSL450.
+  // Memory model for Vulkan is GLSL450 unless the Vulkan memory model is
+  // requested.
 
   // Ops[0] = Addressing Model
   // Ops[1] = Memory Model
   Ops.clear();
-  Ops << spv::AddressingModelLogical << spv::MemoryModelGLSL450;
+  Ops << (clspv::Option::PhysicalStorageBuffers()
+              ? spv::AddressingModelPhysicalStorageBuffer64
+              : spv::AddressingModelLogical)
+      << (clspv::Option::VulkanMemoryModel() ? spv::MemoryModelVulkan
+                                             : spv::MemoryModelGLSL450);
 
   addSPIRVInst<kMemoryModel>(spv::OpMemoryModel, Ops);
 
@@ -2903,9 +3117,13 @@ void SPIRVProducerPass::GenerateModuleInfo() {
     break;
   }
 
-  Ops.clear();
-  Ops << LangID << LangVer;
-  addSPIRVInst<kDebug>(spv::OpSource, Ops);
+  // OpSource is purely informational, so it is omitted when optimizing for
+  // size.
+  if (!clspv::Option::OptimizeSPIRVSize()) {
+    Ops.clear();
+    Ops << LangID << LangVer;
+    addSPIRVInst<kDebug>(spv::OpSource, Ops);
+  }
 
   if (!BuiltinDimVec.empty()) {
     //
@@ -2947,6 +3165,7 @@ void SPIRVProducerPass::GenerateEntryPointInitialStores() {
     Ops << WorkgroupSizeVarID << WorkgroupSizeValueID;
 
     addSPIRVInst(spv::OpStore, Ops);
+    ++NumHackInitializersInstructions;
   }
 }
 
@@ -2962,6 +3181,8 @@ void SPIRVProducerPass::GenerateFuncBody(Function &F) {
     // Generate OpLabel for Basic Block.
     //
     VMap[&BB] = addSPIRVInst(spv::OpLabel);
+    // OpLine does not extend past the end of a block.
+    LastDebugLine = std::make_tuple(0, 0, 0);
 
     // OpVariable instructions must come first.
     for (Instruction &I : BB) {
@@ -3042,7 +3263,9 @@ spv::Op SPIRVProducerPass::GetSPIRVCastOpcode(Instruction &I) {
       {Instruction::SIToFP, spv::OpConvertSToF},
       {Instruction::FPTrunc, spv::OpFConvert},
       {Instruction::FPExt, spv::OpFConvert},
-      {Instruction::BitCast, spv::OpBitcast}};
+      {Instruction::BitCast, spv::OpBitcast},
+      {Instruction::IntToPtr, spv::OpConvertUToPtr},
+      {Instruction::PtrToInt, spv::OpConvertPtrToU}};
 
   assert(0 != Map.count(I.getOpcode()));
 
@@ -3089,7 +3312,7 @@ spv::Op SPIRVProducerPass::GetSPIRVBinaryOpcode(Instruction &I) {
 }
 
 SPIRVID SPIRVProducerPass::getSPIRVBuiltin(spv::BuiltIn BID,
-                                           spv::Capability Cap) {
+                                           spv::Capability Cap, Type *Ty) {
   SPIRVID RID;
 
   auto ii = BuiltinConstantMap.find(BID);
@@ -3099,8 +3322,11 @@ SPIRVID SPIRVProducerPass::getSPIRVBuiltin(spv::BuiltIn BID,
   } else {
     addCapability(Cap);
 
-    Type *type = PointerType::get(IntegerType::get(module->getContext(), 32),
-                                  AddressSpace::Input);
+    // Builtins are 32-bit integers unless stated otherwise.
+    if (!Ty) {
+      Ty = IntegerType::get(module->getContext(), 32);
+    }
+    Type *type = PointerType::get(Ty, AddressSpace::Input);
 
     RID = addSPIRVGlobalVariable(getSPIRVType(type), spv::StorageClassInput);
 
@@ -3183,7 +3409,7 @@ SPIRVProducerPass::GenerateClspvInstruction(CallInst *Call,
     }
 
     for (unsigned i = 0; i < Call->getNumArgOperands(); i++) {
-      Ops << Call->getArgOperand(i);
+      addSyncOperand(Ops, spv::OpAtomicXor, i, Call->getArgOperand(i));
     }
 
     RID = addSPIRVInst(spv::OpAtomicXor, Ops);
@@ -3193,6 +3419,34 @@ SPIRVProducerPass::GenerateClspvInstruction(CallInst *Call,
     // Handle SPIR-V intrinsics
     auto *arg0 = dyn_cast<ConstantInt>(Call->getArgOperand(0));
     spv::Op opcode = static_cast<spv::Op>(arg0->getZExtValue());
+    switch (opcode) {
+    case spv::OpAtomicFAddEXT:
+      addExtension("SPV_EXT_shader_atomic_float_add");
+      addCapability(Call->getType()->isDoubleTy()
+                        ? spv::CapabilityAtomicFloat64AddEXT
+                        : spv::CapabilityAtomicFloat32AddEXT);
+      break;
+    case spv::OpAtomicFMinEXT:
+    case spv::OpAtomicFMaxEXT:
+      addExtension("SPV_EXT_shader_atomic_float_min_max");
+      if (Call->getType()->isHalfTy()) {
+        addCapability(spv::CapabilityAtomicFloat16MinMaxEXT);
+      } else if (Call->getType()->isDoubleTy()) {
+        addCapability(spv::CapabilityAtomicFloat64MinMaxEXT);
+      } else {
+        addCapability(spv::CapabilityAtomicFloat32MinMaxEXT);
+      }
+      break;
+    default:
+      if (opcode >= spv::OpAtomicLoad && opcode <= spv::OpAtomicXor &&
+          Call->getArgOperand(1)
+              ->getType()
+              ->getPointerElementType()
+              ->isIntegerTy(64)) {
+        addCapability(spv::CapabilityInt64Atomics);
+      }
+      break;
+    }
     if (opcode != spv::OpNop) {
       SPIRVOperandVec Ops;
 
@@ -3201,7 +3455,7 @@ SPIRVProducerPass::GenerateClspvInstruction(CallInst *Call,
       }
 
       for (unsigned i = 1; i < Call->getNumArgOperands(); i++) {
-        Ops << Call->getArgOperand(i);
+        addSyncOperand(Ops, opcode, i - 1, Call->getArgOperand(i));
       }
 
       RID = addSPIRVInst(opcode, Ops);
@@ -3248,6 +3502,8 @@ SPIRVProducerPass::GenerateClspvInstruction(CallInst *Call,
         getSPIRVType(dst->getType()->getPointerElementType(), dst_layout);
     auto src_id =
         getSPIRVType(src->getType()->getPointerElementType(), src_layout);
+    const auto DstMemoryAccess = MemoryAccess | getNonPrivateMemoryAccess(dst);
+    const auto SrcMemoryAccess = MemoryAccess | getNonPrivateMemoryAccess(src);
     SPIRVOperandVec Ops;
     if (dst_id.get() != src_id.get()) {
       assert(Option::SpvVersion() >= SPIRVVersion::SPIRV_1_4);
@@ -3257,7 +3513,7 @@ SPIRVProducerPass::GenerateClspvInstruction(CallInst *Call,
       // OpStore
       auto load_type_id =
           getSPIRVType(src->getType()->getPointerElementType(), src_layout);
-      Ops << load_type_id << src << MemoryAccess
+      Ops << load_type_id << src << SrcMemoryAccess
           << static_cast<uint32_t>(SrcAlignment);
       auto load = addSPIRVInst(spv::OpLoad, Ops);
 
@@ -3268,13 +3524,19 @@ SPIRVProducerPass::GenerateClspvInstruction(CallInst *Call,
       auto copy = addSPIRVInst(spv::OpCopyLogical, Ops);
 
       Ops.clear();
-      Ops << dst << copy << MemoryAccess << static_cast<uint32_t>(DstAlignment);
+      Ops << dst << copy << DstMemoryAccess
+          << static_cast<uint32_t>(DstAlignment);
       RID = addSPIRVInst(spv::OpStore, Ops);
+    } else if (SpvVersion() >= SPIRVVersion::SPIRV_1_4) {
+      Ops << dst << src << DstMemoryAccess
+          << static_cast<uint32_t>(DstAlignment) << SrcMemoryAccess
+          << static_cast<uint32_t>(SrcAlignment);
+
+      RID = addSPIRVInst(spv::OpCopyMemory, Ops);
     } else {
-      Ops << dst << src << MemoryAccess << static_cast<uint32_t>(DstAlignment);
-      if (SpvVersion() >= SPIRVVersion::SPIRV_1_4) {
-        Ops << MemoryAccess << static_cast<uint32_t>(SrcAlignment);
-      }
+      // A single set of memory operands applies to both pointers.
+      Ops << dst << src << (DstMemoryAccess & SrcMemoryAccess)
+          << static_cast<uint32_t>(DstAlignment);
 
       RID = addSPIRVInst(spv::OpCopyMemory, Ops);
     }
@@ -3287,6 +3549,28 @@ SPIRVProducerPass::GenerateClspvInstruction(CallInst *Call,
   return RID;
 }
 
+void SPIRVProducerPass::addImageAccessOperands(SPIRVOperandVec &Ops,
+                                               Value *image, uint32_t mask,
+                                               bool is_write) {
+  bool coherent = false;
+  if (clspv::Option::VulkanMemoryModel()) {
+    mask |= spv::ImageOperandsNonPrivateTexelMask;
+    coherent = PointsToCoherentResource(image);
+    if (coherent) {
+      mask |= is_write ? spv::ImageOperandsMakeTexelAvailableMask
+                       : spv::ImageOperandsMakeTexelVisibleMask;
+    }
+  }
+
+  if (mask == 0)
+    return;
+
+  Ops << mask;
+  if (coherent) {
+    Ops << getSPIRVScope(CoherentScope);
+  }
+}
+
 SPIRVID
 SPIRVProducerPass::GenerateImageInstruction(CallInst *Call,
                                             const FunctionInfo &FuncInfo) {
@@ -3392,9 +3676,9 @@ SPIRVProducerPass::GenerateImageInstruction(CallInst *Call,
       }
 
       Ops << result_type << Image << Coordinate;
-      uint32_t mask = GetExtendMask(Call->getType(), is_int_image);
-      if (mask != 0)
-        Ops << mask;
+      addImageAccessOperands(Ops, Image,
+                             GetExtendMask(Call->getType(), is_int_image),
+                             false);
       RID = addSPIRVInst(spv::OpImageRead, Ops);
 
       if (is_int_image) {
@@ -3478,9 +3762,8 @@ SPIRVProducerPass::GenerateImageInstruction(CallInst *Call,
       Ops.clear();
     }
     Ops << Image << Coordinate << TexelID;
-    uint32_t mask = GetExtendMask(Texel->getType(), is_int_image);
-    if (mask != 0)
-      Ops << mask;
+    addImageAccessOperands(Ops, Image,
+                           GetExtendMask(Texel->getType(), is_int_image), true);
     RID = addSPIRVInst(spv::OpImageWrite, Ops);
 
     // Image writes require StorageImageWriteWithoutFormat.
@@ -3597,11 +3880,16 @@ SPIRVProducerPass::GenerateSubgroupInstruction(CallInst *Call,
                                   spv::Capability spvCap =
                                       spv::CapabilityGroupNonUniform) {
     SPIRVOperandVec Ops;
-    Ops << Call->getType() << this->getSPIRVBuiltin(spvBI, spvCap);
+    Ops << Call->getType()
+        << this->getSPIRVBuiltin(spvBI, spvCap, Call->getType());
 
     return addSPIRVInst(spv::OpLoad, Ops);
   };
 
+  // The extensions pass predicates as int where SPIR-V uses bool.
+  bool bool_operand = false;
+  bool bool_result = false;
+
   spv::Op op = spv::OpNop;
   switch (FuncInfo.getType()) {
   case Builtins::kGetSubGroupSize:
@@ -3612,8 +3900,24 @@ SPIRVProducerPass::GenerateSubgroupInstruction(CallInst *Call,
     return loadBuiltin(spv::BuiltInSubgroupId);
   case Builtins::kGetSubGroupLocalId:
     return loadBuiltin(spv::BuiltInSubgroupLocalInvocationId);
+  case Builtins::kGetSubGroupEqMask:
+    return loadBuiltin(spv::BuiltInSubgroupEqMask,
+                       spv::CapabilityGroupNonUniformBallot);
+  case Builtins::kGetSubGroupGeMask:
+    return loadBuiltin(spv::BuiltInSubgroupGeMask,
+                       spv::CapabilityGroupNonUniformBallot);
+  case Builtins::kGetSubGroupGtMask:
+    return loadBuiltin(spv::BuiltInSubgroupGtMask,
+                       spv::CapabilityGroupNonUniformBallot);
+  case Builtins::kGetSubGroupLeMask:
+    return loadBuiltin(spv::BuiltInSubgroupLeMask,
+                       spv::CapabilityGroupNonUniformBallot);
+  case Builtins::kGetSubGroupLtMask:
+    return loadBuiltin(spv::BuiltInSubgroupLtMask,
+                       spv::CapabilityGroupNonUniformBallot);
 
   case Builtins::kSubGroupBroadcast:
+  case Builtins::kSubGroupNonUniformBroadcast:
     if (SpvVersion() < SPIRVVersion::SPIRV_1_5 &&
         !dyn_cast<ConstantInt>(Call->getOperand(1))) {
       llvm_unreachable("sub_group_broadcast requires constant lane Id for "
@@ -3623,13 +3927,73 @@ SPIRVProducerPass::GenerateSubgroupInstruction(CallInst *Call,
     op = spv::OpGroupNonUniformBroadcast;
     break;
 
+  case Builtins::kSubGroupBroadcastFirst:
+    addCapability(spv::CapabilityGroupNonUniformBallot);
+    op = spv::OpGroupNonUniformBroadcastFirst;
+    break;
+
   case Builtins::kSubGroupAll:
     addCapability(spv::CapabilityGroupNonUniformVote);
     op = spv::OpGroupNonUniformAll;
+    bool_operand = bool_result = true;
     break;
   case Builtins::kSubGroupAny:
     addCapability(spv::CapabilityGroupNonUniformVote);
     op = spv::OpGroupNonUniformAny;
+    bool_operand = bool_result = true;
+    break;
+
+  case Builtins::kSubGroupElect:
+    addCapability(spv::CapabilityGroupNonUniform);
+    op = spv::OpGroupNonUniformElect;
+    bool_result = true;
+    break;
+
+  case Builtins::kSubGroupShuffle:
+    addCapability(spv::CapabilityGroupNonUniformShuffle);
+    op = spv::OpGroupNonUniformShuffle;
+    break;
+  case Builtins::kSubGroupShuffleXor:
+    addCapability(spv::CapabilityGroupNonUniformShuffle);
+    op = spv::OpGroupNonUniformShuffleXor;
+    break;
+  case Builtins::kSubGroupShuffleUp:
+    addCapability(spv::CapabilityGroupNonUniformShuffleRelative);
+    op = spv::OpGroupNonUniformShuffleUp;
+    break;
+  case Builtins::kSubGroupShuffleDown:
+    addCapability(spv::CapabilityGroupNonUniformShuffleRelative);
+    op = spv::OpGroupNonUniformShuffleDown;
+    break;
+
+  case Builtins::kSubGroupBallot:
+    addCapability(spv::CapabilityGroupNonUniformBallot);
+    op = spv::OpGroupNonUniformBallot;
+    bool_operand = true;
+    break;
+  case Builtins::kSubGroupInverseBallot:
+    addCapability(spv::CapabilityGroupNonUniformBallot);
+    op = spv::OpGroupNonUniformInverseBallot;
+    bool_result = true;
+    break;
+  case Builtins::kSubGroupBallotBitExtract:
+    addCapability(spv::CapabilityGroupNonUniformBallot);
+    op = spv::OpGroupNonUniformBallotBitExtract;
+    bool_result = true;
+    break;
+  case Builtins::kSubGroupBallotBitCount:
+  case Builtins::kSubGroupBallotInclusiveScan:
+  case Builtins::kSubGroupBallotExclusiveScan:
+    addCapability(spv::CapabilityGroupNonUniformBallot);
+    op = spv::OpGroupNonUniformBallotBitCount;
+    break;
+  case Builtins::kSubGroupBallotFindLSB:
+    addCapability(spv::CapabilityGroupNonUniformBallot);
+    op = spv::OpGroupNonUniformBallotFindLSB;
+    break;
+  case Builtins::kSubGroupBallotFindMSB:
+    addCapability(spv::CapabilityGroupNonUniformBallot);
+    op = spv::OpGroupNonUniformBallotFindMSB;
     break;
   case Builtins::kSubGroupReduceAdd:
   case Builtins::kSubGroupScanExclusiveAdd:
@@ -3669,6 +4033,71 @@ SPIRVProducerPass::GenerateSubgroupInstruction(CallInst *Call,
     break;
   }
 
+  case Builtins::kSubGroupNonUniformAdd:
+  case Builtins::kSubGroupNonUniformMul:
+  case Builtins::kSubGroupNonUniformMin:
+  case Builtins::kSubGroupNonUniformMax:
+  case Builtins::kSubGroupNonUniformAnd:
+  case Builtins::kSubGroupNonUniformOr:
+  case Builtins::kSubGroupNonUniformXor:
+  case Builtins::kSubGroupNonUniformLogicalAnd:
+  case Builtins::kSubGroupNonUniformLogicalOr:
+  case Builtins::kSubGroupNonUniformLogicalXor: {
+    if (StringRef(FuncInfo.getName()).startswith("sub_group_clustered_")) {
+      addCapability(spv::CapabilityGroupNonUniformClustered);
+    } else {
+      addCapability(spv::CapabilityGroupNonUniformArithmetic);
+    }
+    auto &param = FuncInfo.getParameter(0);
+    bool is_int = param.type_id == Type::IntegerTyID;
+    switch (FuncInfo.getType()) {
+    case Builtins::kSubGroupNonUniformAdd:
+      op = is_int ? spv::OpGroupNonUniformIAdd : spv::OpGroupNonUniformFAdd;
+      break;
+    case Builtins::kSubGroupNonUniformMul:
+      op = is_int ? spv::OpGroupNonUniformIMul : spv::OpGroupNonUniformFMul;
+      break;
+    case Builtins::kSubGroupNonUniformMin:
+      if (is_int) {
+        op = param.is_signed ? spv::OpGroupNonUniformSMin
+                             : spv::OpGroupNonUniformUMin;
+      } else {
+        op = spv::OpGroupNonUniformFMin;
+      }
+      break;
+    case Builtins::kSubGroupNonUniformMax:
+      if (is_int) {
+        op = param.is_signed ? spv::OpGroupNonUniformSMax
+                             : spv::OpGroupNonUniformUMax;
+      } else {
+        op = spv::OpGroupNonUniformFMax;
+      }
+      break;
+    case Builtins::kSubGroupNonUniformAnd:
+      op = spv::OpGroupNonUniformBitwiseAnd;
+      break;
+    case Builtins::kSubGroupNonUniformOr:
+      op = spv::OpGroupNonUniformBitwiseOr;
+      break;
+    case Builtins::kSubGroupNonUniformXor:
+      op = spv::OpGroupNonUniformBitwiseXor;
+      break;
+    case Builtins::kSubGroupNonUniformLogicalAnd:
+      op = spv::OpGroupNonUniformLogicalAnd;
+      bool_operand = bool_result = true;
+      break;
+    case Builtins::kSubGroupNonUniformLogicalOr:
+      op = spv::OpGroupNonUniformLogicalOr;
+      bool_operand = bool_result = true;
+      break;
+    default:
+      op = spv::OpGroupNonUniformLogicalXor;
+      bool_operand = bool_result = true;
+      break;
+    }
+    break;
+  }
+
   case Builtins::kGetEnqueuedNumSubGroups:
     // TODO(sjw): requires CapabilityKernel (incompatible with Shader)
   case Builtins::kGetMaxSubGroupSize:
@@ -3699,7 +4128,12 @@ SPIRVProducerPass::GenerateSubgroupInstruction(CallInst *Call,
   // Ops[3] = Local ID
 
   // The result type.
-  Operands << Call->getType();
+  Type *bool_type = Type::getInt1Ty(module->getContext());
+  if (bool_result) {
+    Operands << bool_type;
+  } else {
+    Operands << Call->getType();
+  }
 
   // Subgroup Scope
   Operands << getSPIRVInt32Constant(spv::ScopeSubgroup);
@@ -3708,27 +4142,69 @@ SPIRVProducerPass::GenerateSubgroupInstruction(CallInst *Call,
   case Builtins::kSubGroupReduceAdd:
   case Builtins::kSubGroupReduceMin:
   case Builtins::kSubGroupReduceMax:
+  case Builtins::kSubGroupBallotBitCount:
     Operands << spv::GroupOperationReduce;
     break;
   case Builtins::kSubGroupScanExclusiveAdd:
   case Builtins::kSubGroupScanExclusiveMin:
   case Builtins::kSubGroupScanExclusiveMax:
+  case Builtins::kSubGroupBallotExclusiveScan:
     Operands << spv::GroupOperationExclusiveScan;
     break;
   case Builtins::kSubGroupScanInclusiveAdd:
   case Builtins::kSubGroupScanInclusiveMin:
   case Builtins::kSubGroupScanInclusiveMax:
+  case Builtins::kSubGroupBallotInclusiveScan:
     Operands << spv::GroupOperationInclusiveScan;
     break;
+  case Builtins::kSubGroupNonUniformAdd:
+  case Builtins::kSubGroupNonUniformMul:
+  case Builtins::kSubGroupNonUniformMin:
+  case Builtins::kSubGroupNonUniformMax:
+  case Builtins::kSubGroupNonUniformAnd:
+  case Builtins::kSubGroupNonUniformOr:
+  case Builtins::kSubGroupNonUniformXor:
+  case Builtins::kSubGroupNonUniformLogicalAnd:
+  case Builtins::kSubGroupNonUniformLogicalOr:
+  case Builtins::kSubGroupNonUniformLogicalXor: {
+    // The group operation is part of the builtin name.
+    StringRef name = FuncInfo.getName();
+    if (name.startswith("sub_group_clustered_reduce_")) {
+      Operands << spv::GroupOperationClusteredReduce;
+    } else if (name.startswith("sub_group_non_uniform_scan_exclusive_")) {
+      Operands << spv::GroupOperationExclusiveScan;
+    } else if (name.startswith("sub_group_non_uniform_scan_inclusive_")) {
+      Operands << spv::GroupOperationInclusiveScan;
+    } else {
+      Operands << spv::GroupOperationReduce;
+    }
+    break;
+  }
   default:
     break;
   }
 
   for (Use &use : Call->arg_operands()) {
-    Operands << use.get();
+    if (bool_operand && use.getOperandNo() == 0) {
+      SPIRVOperandVec Ops;
+      Ops << bool_type << use.get()
+          << Constant::getNullValue(use.get()->getType());
+      Operands << addSPIRVInst(spv::OpINotEqual, Ops);
+    } else {
+      Operands << use.get();
+    }
   }
 
-  return addSPIRVInst(op, Operands);
+  RID = addSPIRVInst(op, Operands);
+
+  if (bool_result) {
+    SPIRVOperandVec Ops;
+    Ops << Call->getType() << RID << ConstantInt::get(Call->getType(), 1)
+        << ConstantInt::get(Call->getType(), 0);
+    RID = addSPIRVInst(spv::OpSelect, Ops);
+  }
+
+  return RID;
 }
 
 SPIRVID SPIRVProducerPass::GenerateInstructionFromCall(CallInst *Call) {
@@ -3890,10 +4366,44 @@ SPIRVID SPIRVProducerPass::GenerateInstructionFromCall(CallInst *Call) {
   return RID;
 }
 
+void SPIRVProducerPass::GenerateDebugLine(Instruction &I) {
+  const DILocation *loc = I.getDebugLoc().get();
+  if (!loc)
+    return;
+
+  SmallString<128> path(loc->getFilename());
+  if (!sys::path::is_absolute(path) && !loc->getDirectory().empty()) {
+    path = loc->getDirectory();
+    sys::path::append(path, loc->getFilename());
+  }
+  auto where = DebugFileStrings.find(path);
+  if (where == DebugFileStrings.end()) {
+    auto file_id = addSPIRVInst<kDebug>(spv::OpString, path.c_str());
+    where = DebugFileStrings.try_emplace(path, file_id).first;
+  }
+
+  auto line = std::make_tuple(where->second.get(), loc->getLine(),
+                              static_cast<uint32_t>(loc->getColumn()));
+  if (line == LastDebugLine)
+    return;
+  LastDebugLine = line;
+
+  // Ops[0] = File (OpString) ID
+  // Ops[1] = Line (Literal Number)
+  // Ops[2] = Column (Literal Number)
+  SPIRVOperandVec Ops;
+  Ops << where->second << std::get<1>(line) << std::get<2>(line);
+  addSPIRVInst(spv::OpLine, Ops);
+}
+
 void SPIRVProducerPass::GenerateInstruction(Instruction &I) {
   ValueMapType &VMap = getValueMap();
   LLVMContext &Context = module->getContext();
 
+  if (clspv::Option::DebugInfo()) {
+    GenerateDebugLine(I);
+  }
+
   SPIRVID RID;
 
   switch (I.getOpcode()) {
@@ -4086,6 +4596,7 @@ void SPIRVProducerPass::GenerateInstruction(Instruction &I) {
       setVariablePointersCapabilities(address_space);
       switch (GetStorageClass(address_space)) {
       case spv::StorageClassStorageBuffer:
+      case spv::StorageClassPhysicalStorageBuffer:
         // Save the need to generate an ArrayStride decoration.  But defer
         // generation until later, so we only make one decoration.
         getTypesNeedingArrayStride().insert(GEP->getPointerOperandType());
@@ -4163,7 +4674,8 @@ void SPIRVProducerPass::GenerateInstruction(Instruction &I) {
       } else {
         // Selecting between pointers requires variable pointers.
         setVariablePointersCapabilities(Ty->getPointerAddressSpace());
-        if (!hasVariablePointers() && !selectFromSameObject(&I)) {
+        if (!IsPhysicalPointer(Ty) && !hasVariablePointers() &&
+            !selectFromSameObject(&I)) {
           setVariablePointers();
         }
       }
@@ -4500,6 +5012,14 @@ void SPIRVProducerPass::GenerateInstruction(Instruction &I) {
     Ops << I.getType() << spv::StorageClassFunction;
 
     RID = addSPIRVInst(spv::OpVariable, Ops);
+
+    if (IsPhysicalPointer(cast<AllocaInst>(I).getAllocatedType())) {
+      // Variables holding physical pointers must declare whether the pointers
+      // alias.
+      Ops.clear();
+      Ops << RID << spv::DecorationAliasedPointer;
+      addSPIRVInst<kAnnotations>(spv::OpDecorate, Ops);
+    }
     break;
   }
   case Instruction::Load: {
@@ -4552,6 +5072,7 @@ void SPIRVProducerPass::GenerateInstruction(Instruction &I) {
     }
     SPIRVOperandVec Ops;
     Ops << result_type_id << ptr;
+    addMemoryAccessOperands(Ops, ptr, LD->getAlign().value(), false);
 
     RID = addSPIRVInst(spv::OpLoad, Ops);
 
@@ -4604,6 +5125,7 @@ void SPIRVProducerPass::GenerateInstruction(Instruction &I) {
     } else {
       Ops << ST->getValueOperand();
     }
+    addMemoryAccessOperands(Ops, ptr, ST->getAlign().value(), true);
     RID = addSPIRVInst(spv::OpStore, Ops);
     break;
   }
@@ -4653,6 +5175,10 @@ void SPIRVProducerPass::GenerateInstruction(Instruction &I) {
       break;
     }
 
+    if (I.getType()->isIntegerTy(64)) {
+      addCapability(spv::CapabilityInt64Atomics);
+    }
+
     //
     // Generate OpAtomic*.
     //
@@ -4660,12 +5186,15 @@ void SPIRVProducerPass::GenerateInstruction(Instruction &I) {
 
     Ops << I.getType() << AtomicRMW->getPointerOperand();
 
-    const auto ConstantScopeDevice = getSPIRVInt32Constant(spv::ScopeDevice);
+    const auto ConstantScopeDevice = getSPIRVScope(spv::ScopeDevice);
     Ops << ConstantScopeDevice;
 
-    const auto ConstantMemorySemantics =
-        getSPIRVInt32Constant(spv::MemorySemanticsUniformMemoryMask |
-                              spv::MemorySemanticsSequentiallyConsistentMask);
+    uint32_t MemorySemantics = spv::MemorySemanticsUniformMemoryMask |
+                               spv::MemorySemanticsSequentiallyConsistentMask;
+    if (clspv::Option::VulkanMemoryModel()) {
+      MemorySemantics = getVulkanMemorySemantics(opcode, MemorySemantics, false);
+    }
+    const auto ConstantMemorySemantics = getSPIRVInt32Constant(MemorySemantics);
     Ops << ConstantMemorySemantics << AtomicRMW->getValOperand();
 
     RID = addSPIRVInst(opcode, Ops);
@@ -4815,7 +5344,8 @@ void SPIRVProducerPass::HandleDeferredInstruction() {
         // OpPhi on pointers requires variable pointers.
         setVariablePointersCapabilities(
             PHI->getType()->getPointerAddressSpace());
-        if (!hasVariablePointers() && !selectFromSameObject(PHI)) {
+        if (!IsPhysicalPointer(PHI->getType()) && !hasVariablePointers() &&
+            !selectFromSameObject(PHI)) {
           setVariablePointers();
         }
       }
@@ -4918,6 +5448,8 @@ void SPIRVProducerPass::HandleDeferredInstruction() {
       }
     }
   }
+
+  DeferredInsts.clear();
 }
 
 void SPIRVProducerPass::HandleDeferredDecorations() {
@@ -5265,10 +5797,111 @@ void SPIRVProducerPass::WriteOperand(const SPIRVOperand &Op) {
 
 void SPIRVProducerPass::WriteSPIRVBinary() {
   for (int i = 0; i < kSectionCount; ++i) {
+    if (i == kFunctions && FunctionSpillOut) {
+      WriteSpilledFunctions();
+    }
     WriteSPIRVBinary(SPIRVSections[i]);
   }
 }
 
+void SPIRVProducerPass::OpenFunctionSpillFile() {
+  int FD;
+  if (auto error = sys::fs::createTemporaryFile("clspv-functions", "spv", FD,
+                                                FunctionSpillPath)) {
+    // The pass cannot return an error, so fail the compilation.
+    report_fatal_error(
+        Twine("Unable to create temporary file for functions: ") +
+            error.message(),
+        /* gen_crash_diag = */ false);
+  }
+  FunctionSpillOut.reset(new raw_fd_ostream(FD, /* shouldClose = */ true));
+}
+
+void SPIRVProducerPass::SpillFunctions() {
+  auto *savedOut = binaryOut;
+  binaryOut = FunctionSpillOut.get();
+  WriteSPIRVBinary(SPIRVSections[kFunctions]);
+  binaryOut = savedOut;
+  SPIRVSections[kFunctions].clear();
+}
+
+void SPIRVProducerPass::WriteSpilledFunctions() {
+  FunctionSpillOut->close();
+  if (auto error = FunctionSpillOut->error()) {
+    FunctionSpillOut->clear_error();
+    sys::fs::remove(FunctionSpillPath);
+    report_fatal_error("Unable to write spilled functions to " +
+                           FunctionSpillPath + ": " + error.message(),
+                       /* gen_crash_diag = */ false);
+  }
+  FunctionSpillOut.reset();
+
+  // Copy in fixed-size chunks so the functions are never all in memory.
+  auto FD = sys::fs::openNativeFileForRead(FunctionSpillPath);
+  if (!FD) {
+    report_fatal_error("Unable to read spilled functions from " +
+                           FunctionSpillPath + ": " +
+                           toString(FD.takeError()),
+                       /* gen_crash_diag = */ false);
+  }
+  std::vector<char> chunk(1 << 16);
+  while (true) {
+    auto bytes = sys::fs::readNativeFile(*FD, chunk);
+    if (!bytes) {
+      sys::fs::closeFile(*FD);
+      report_fatal_error("Unable to read spilled functions from " +
+                             FunctionSpillPath + ": " +
+                             toString(bytes.takeError()),
+                         /* gen_crash_diag = */ false);
+    }
+    if (*bytes == 0)
+      break;
+    binaryOut->write(chunk.data(), *bytes);
+  }
+  sys::fs::closeFile(*FD);
+  sys::fs::remove(FunctionSpillPath);
+}
+
+void SPIRVProducerPass::CompactSPIRVIDs() {
+  // IDs are handed out in generation order, which includes placeholders that
+  // are later replaced by instructions without results. Assigning new IDs in
+  // the order they are encountered in the final binary removes those holes
+  // and makes the numbering depend only on the emitted instruction stream.
+  DenseMap<uint32_t, uint32_t> Remap;
+  uint32_t NewID = 1;
+  auto remap = [&Remap, &NewID](uint32_t OldID) {
+    auto where = Remap.try_emplace(OldID, NewID);
+    if (where.second)
+      ++NewID;
+    return where.first->second;
+  };
+
+  for (auto &SPIRVInstList : SPIRVSections) {
+    for (auto &Inst : SPIRVInstList) {
+      bool has_result, has_result_type;
+      spv::HasResultAndType(static_cast<spv::Op>(Inst.getOpcode()),
+                            &has_result, &has_result_type);
+      auto &Ops = Inst.getOperands();
+      unsigned first = 0;
+      // The result type precedes the result ID in the binary.
+      if (has_result_type && !Ops.empty()) {
+        Ops[0].setNumID(remap(Ops[0].getNumID()));
+        first = 1;
+      }
+      if (Inst.getResultID().isValid()) {
+        Inst.setResultID(remap(Inst.getResultID().get()));
+      }
+      for (unsigned i = first; i < Ops.size(); ++i) {
+        if (Ops[i].getType() == NUMBERID) {
+          Ops[i].setNumID(remap(Ops[i].getNumID()));
+        }
+      }
+    }
+  }
+
+  nextID = NewID;
+}
+
 void SPIRVProducerPass::WriteSPIRVBinary(SPIRVInstructionList &SPIRVInstList) {
   for (const auto &Inst : SPIRVInstList) {
     const auto &Ops = Inst.getOperands();
@@ -5287,6 +5920,7 @@ void SPIRVProducerPass::WriteSPIRVBinary(SPIRVInstructionList &SPIRVInstList) {
     case spv::OpEntryPoint:
     case spv::OpExecutionMode:
     case spv::OpSource:
+    case spv::OpLine:
     case spv::OpDecorate:
     case spv::OpMemberDecorate:
     case spv::OpBranch:
@@ -5435,6 +6069,9 @@ void SPIRVProducerPass::WriteSPIRVBinary(SPIRVInstructionList &SPIRVInstList) {
     case spv::OpAtomicLoad:
     case spv::OpAtomicIAdd:
     case spv::OpAtomicISub:
+    case spv::OpAtomicFAddEXT:
+    case spv::OpAtomicFMinEXT:
+    case spv::OpAtomicFMaxEXT:
     case spv::OpAtomicExchange:
     case spv::OpAtomicIIncrement:
     case spv::OpAtomicIDecrement:
@@ -5450,14 +6087,34 @@ void SPIRVProducerPass::WriteSPIRVBinary(SPIRVInstructionList &SPIRVInstList) {
     case spv::OpGroupNonUniformAll:
     case spv::OpGroupNonUniformAny:
     case spv::OpGroupNonUniformBroadcast:
+    case spv::OpGroupNonUniformElect:
+    case spv::OpGroupNonUniformBroadcastFirst:
+    case spv::OpGroupNonUniformBallot:
+    case spv::OpGroupNonUniformInverseBallot:
+    case spv::OpGroupNonUniformBallotBitExtract:
+    case spv::OpGroupNonUniformBallotBitCount:
+    case spv::OpGroupNonUniformBallotFindLSB:
+    case spv::OpGroupNonUniformBallotFindMSB:
+    case spv::OpGroupNonUniformShuffle:
+    case spv::OpGroupNonUniformShuffleXor:
+    case spv::OpGroupNonUniformShuffleUp:
+    case spv::OpGroupNonUniformShuffleDown:
     case spv::OpGroupNonUniformIAdd:
     case spv::OpGroupNonUniformFAdd:
+    case spv::OpGroupNonUniformIMul:
+    case spv::OpGroupNonUniformFMul:
     case spv::OpGroupNonUniformSMin:
     case spv::OpGroupNonUniformUMin:
     case spv::OpGroupNonUniformFMin:
     case spv::OpGroupNonUniformSMax:
     case spv::OpGroupNonUniformUMax:
-    case spv::OpGroupNonUniformFMax: {
+    case spv::OpGroupNonUniformFMax:
+    case spv::OpGroupNonUniformBitwiseAnd:
+    case spv::OpGroupNonUniformBitwiseOr:
+    case spv::OpGroupNonUniformBitwiseXor:
+    case spv::OpGroupNonUniformLogicalAnd:
+    case spv::OpGroupNonUniformLogicalOr:
+    case spv::OpGroupNonUniformLogicalXor: {
       WriteWordCountAndOpcode(Inst);
       WriteOperand(Ops[0]);
       WriteResultID(Inst);
@@ -5597,10 +6254,16 @@ uint32_t SPIRVProducerPass::GetExplicitLayoutStructMemberOffset(
 
 void SPIRVProducerPass::setVariablePointersCapabilities(
     unsigned address_space) {
-  if (GetStorageClass(address_space) == spv::StorageClassStorageBuffer) {
+  switch (GetStorageClass(address_space)) {
+  case spv::StorageClassPhysicalStorageBuffer:
+    // Physical pointers are not restricted by the logical addressing model.
+    break;
+  case spv::StorageClassStorageBuffer:
     setVariablePointersStorageBuffer();
-  } else {
+    break;
+  default:
     setVariablePointers();
+    break;
   }
 }
 
@@ -5707,13 +6370,13 @@ bool SPIRVProducerPass::CalledWithCoherentResource(Argument &Arg) {
     return false;
   }
 
+  return PointsToCoherentResource(&Arg);
+}
+
+bool SPIRVProducerPass::PointsToCoherentResource(Value *ptr) {
   DenseSet<Value *> visited;
   std::vector<Value *> stack;
-  for (auto *U : Arg.getParent()->users()) {
-    if (auto *call = dyn_cast<CallInst>(U)) {
-      stack.push_back(call->getOperand(Arg.getArgNo()));
-    }
-  }
+  stack.push_back(ptr);
 
   while (!stack.empty()) {
     Value *v = stack.back();
@@ -5758,6 +6421,241 @@ bool SPIRVProducerPass::CalledWithCoherentResource(Argument &Arg) {
   return false;
 }
 
+void SPIRVProducerPass::FindCoherentScope() {
+  // Under the Vulkan memory model coherence is relative to a scope. Resources
+  // only need to be coherent with the invocations they synchronize with, so
+  // use the widest scope of the barriers, fences and atomics ordering global
+  // memory. Workgroup barriers therefore only require workgroup coherence.
+  const uint32_t global_semantics = spv::MemorySemanticsUniformMemoryMask |
+                                    spv::MemorySemanticsImageMemoryMask;
+  const uint32_t ordering_semantics =
+      spv::MemorySemanticsAcquireMask | spv::MemorySemanticsReleaseMask |
+      spv::MemorySemanticsAcquireReleaseMask |
+      spv::MemorySemanticsSequentiallyConsistentMask;
+  auto widen = [this](Value *scope) {
+    auto *scope_const = dyn_cast<ConstantInt>(scope);
+    if (!scope_const) {
+      CoherentScope = spv::ScopeDevice;
+      return;
+    }
+    switch (scope_const->getZExtValue()) {
+    case spv::ScopeWorkgroup:
+    case spv::ScopeSubgroup:
+    case spv::ScopeInvocation:
+      break;
+    default:
+      CoherentScope = spv::ScopeDevice;
+      break;
+    }
+  };
+
+  for (auto &F : *module) {
+    for (auto &BB : F) {
+      for (auto &I : BB) {
+        if (isa<AtomicRMWInst>(&I)) {
+          // Atomic read-modify-writes are sequentially consistent at device
+          // scope.
+          CoherentScope = spv::ScopeDevice;
+          return;
+        }
+
+        auto *call = dyn_cast<CallInst>(&I);
+        if (!call || !call->getCalledFunction() ||
+            Builtins::Lookup(call->getCalledFunction()).getType() !=
+                Builtins::kSpirvOp)
+          continue;
+
+        auto opcode = static_cast<spv::Op>(
+            cast<ConstantInt>(call->getArgOperand(0))->getZExtValue());
+        unsigned scope_index = 0;
+        unsigned semantics_index = 0;
+        switch (opcode) {
+        case spv::OpControlBarrier:
+          scope_index = 2;
+          semantics_index = 3;
+          break;
+        case spv::OpMemoryBarrier:
+          scope_index = 1;
+          semantics_index = 2;
+          break;
+        case spv::OpAtomicFAddEXT:
+        case spv::OpAtomicFMinEXT:
+        case spv::OpAtomicFMaxEXT:
+          scope_index = 2;
+          semantics_index = 3;
+          break;
+        default:
+          if (opcode >= spv::OpAtomicLoad && opcode <= spv::OpAtomicXor) {
+            scope_index = 2;
+            semantics_index = 3;
+          }
+          break;
+        }
+        if (semantics_index == 0)
+          continue;
+
+        auto *semantics =
+            dyn_cast<ConstantInt>(call->getArgOperand(semantics_index));
+        if (!semantics ||
+            ((semantics->getZExtValue() & global_semantics) &&
+             (semantics->getZExtValue() & ordering_semantics))) {
+          widen(call->getArgOperand(scope_index));
+        }
+      }
+    }
+  }
+}
+
+SPIRVID SPIRVProducerPass::getSPIRVScope(uint32_t scope) {
+  if (clspv::Option::VulkanMemoryModel() && scope == spv::ScopeDevice) {
+    addCapability(spv::CapabilityVulkanMemoryModelDeviceScope);
+  }
+  return getSPIRVInt32Constant(scope);
+}
+
+uint32_t SPIRVProducerPass::getVulkanMemorySemantics(spv::Op opcode,
+                                                     uint32_t semantics,
+                                                     bool unequal) const {
+  // Atomic loads and failed compare-exchanges only acquire, atomic stores
+  // only release.
+  const bool can_acquire = opcode != spv::OpAtomicStore;
+  const bool can_release = opcode != spv::OpAtomicLoad && !unequal;
+
+  uint32_t ordering = semantics & (spv::MemorySemanticsAcquireMask |
+                                   spv::MemorySemanticsReleaseMask |
+                                   spv::MemorySemanticsAcquireReleaseMask |
+                                   spv::MemorySemanticsSequentiallyConsistentMask);
+  semantics &= ~ordering;
+  bool acquire = ordering & (spv::MemorySemanticsAcquireMask |
+                             spv::MemorySemanticsAcquireReleaseMask |
+                             spv::MemorySemanticsSequentiallyConsistentMask);
+  bool release = ordering & (spv::MemorySemanticsReleaseMask |
+                             spv::MemorySemanticsAcquireReleaseMask |
+                             spv::MemorySemanticsSequentiallyConsistentMask);
+  acquire = acquire && can_acquire;
+  release = release && can_release;
+
+  if (acquire && release) {
+    semantics |= spv::MemorySemanticsAcquireReleaseMask |
+                 spv::MemorySemanticsMakeAvailableMask |
+                 spv::MemorySemanticsMakeVisibleMask;
+  } else if (acquire) {
+    semantics |=
+        spv::MemorySemanticsAcquireMask | spv::MemorySemanticsMakeVisibleMask;
+  } else if (release) {
+    semantics |=
+        spv::MemorySemanticsReleaseMask | spv::MemorySemanticsMakeAvailableMask;
+  } else {
+    // Relaxed semantics cannot order any storage class.
+    semantics &= ~(spv::MemorySemanticsUniformMemoryMask |
+                   spv::MemorySemanticsWorkgroupMemoryMask |
+                   spv::MemorySemanticsImageMemoryMask);
+  }
+
+  return semantics;
+}
+
+void SPIRVProducerPass::addSyncOperand(SPIRVOperandVec &Ops, spv::Op opcode,
+                                       unsigned index, Value *V) {
+  auto *value = dyn_cast<ConstantInt>(V);
+  if (!clspv::Option::VulkanMemoryModel() || !value) {
+    Ops << V;
+    return;
+  }
+
+  enum { kOther, kScope, kSemantics, kUnequalSemantics } kind = kOther;
+  switch (opcode) {
+  case spv::OpControlBarrier:
+    kind = index < 2 ? kScope : index == 2 ? kSemantics : kOther;
+    break;
+  case spv::OpMemoryBarrier:
+    kind = index == 0 ? kScope : index == 1 ? kSemantics : kOther;
+    break;
+  case spv::OpAtomicCompareExchange:
+  case spv::OpAtomicCompareExchangeWeak:
+    kind = index == 1   ? kScope
+           : index == 2 ? kSemantics
+           : index == 3 ? kUnequalSemantics
+                        : kOther;
+    break;
+  default:
+    if ((opcode >= spv::OpAtomicLoad && opcode <= spv::OpAtomicXor) ||
+        opcode == spv::OpAtomicFAddEXT || opcode == spv::OpAtomicFMinEXT ||
+        opcode == spv::OpAtomicFMaxEXT) {
+      kind = index == 1 ? kScope : index == 2 ? kSemantics : kOther;
+    }
+    break;
+  }
+
+  const auto raw = static_cast<uint32_t>(value->getZExtValue());
+  switch (kind) {
+  case kScope:
+    Ops << getSPIRVScope(raw);
+    break;
+  case kSemantics:
+    Ops << getSPIRVInt32Constant(getVulkanMemorySemantics(opcode, raw, false));
+    break;
+  case kUnequalSemantics:
+    Ops << getSPIRVInt32Constant(getVulkanMemorySemantics(opcode, raw, true));
+    break;
+  default:
+    Ops << V;
+    break;
+  }
+}
+
+uint32_t SPIRVProducerPass::getNonPrivateMemoryAccess(Value *ptr) const {
+  if (!clspv::Option::VulkanMemoryModel())
+    return spv::MemoryAccessMaskNone;
+
+  // Only accesses to memory shared between invocations are ordered by
+  // barriers and atomics.
+  switch (GetStorageClass(ptr->getType()->getPointerAddressSpace())) {
+  case spv::StorageClassStorageBuffer:
+  case spv::StorageClassPhysicalStorageBuffer:
+  case spv::StorageClassWorkgroup:
+    return spv::MemoryAccessNonPrivatePointerMask;
+  default:
+    return spv::MemoryAccessMaskNone;
+  }
+}
+
+void SPIRVProducerPass::addMemoryAccessOperands(SPIRVOperandVec &Ops,
+                                                Value *ptr, uint64_t align,
+                                                bool is_store) {
+  uint32_t mask = getNonPrivateMemoryAccess(ptr);
+
+  // Accesses through physical pointers must declare their alignment.
+  const bool aligned = IsPhysicalPointer(ptr->getType());
+  if (aligned) {
+    mask |= spv::MemoryAccessAlignedMask;
+  }
+
+  // Coherent resources are not decorated under the Vulkan memory model.
+  // Instead each access makes its writes available or the writes of others
+  // visible.
+  const bool coherent = (mask & spv::MemoryAccessNonPrivatePointerMask) &&
+                        ptr->getType()->getPointerAddressSpace() ==
+                            clspv::AddressSpace::Global &&
+                        PointsToCoherentResource(ptr);
+  if (coherent) {
+    mask |= is_store ? spv::MemoryAccessMakePointerAvailableMask
+                     : spv::MemoryAccessMakePointerVisibleMask;
+  }
+
+  if (mask == spv::MemoryAccessMaskNone)
+    return;
+
+  // Operands follow the order of the mask bits.
+  Ops << mask;
+  if (aligned) {
+    Ops << static_cast<uint32_t>(align);
+  }
+  if (coherent) {
+    Ops << getSPIRVScope(CoherentScope);
+  }
+}
+
 void SPIRVProducerPass::PopulateStructuredCFGMaps() {
   // First, track loop merges and continues.
   DenseSet<BasicBlock *> LoopMergesAndContinues;
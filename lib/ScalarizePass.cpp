@@ -15,6 +15,7 @@
 #include <vector>
 
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/IR/BasicBlock.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/Module.h"
@@ -27,6 +28,13 @@
 
 using namespace llvm;
 
+#define DEBUG_TYPE "scalarize"
+
+STATISTIC(NumHackPhisInstructionsAdded,
+          "Number of instructions added by -hack-phis");
+STATISTIC(NumHackPhisInstructionsRemoved,
+          "Number of instructions removed by -hack-phis");
+
 namespace {
 class ScalarizePass : public ModulePass {
 public:
@@ -56,6 +64,7 @@ INITIALIZE_PASS(ScalarizePass, "Scalarize",
                 false)
 
 bool ScalarizePass::runOnModule(Module &M) {
+  const unsigned NumInstructions = M.getInstructionCount();
   bool Changed = false;
   for (auto &F : M) {
     for (auto &BB : F) {
@@ -73,6 +82,14 @@ bool ScalarizePass::runOnModule(Module &M) {
   for (auto *phi : to_delete_)
     phi->eraseFromParent();
 
+  const int64_t Delta =
+      int64_t(M.getInstructionCount()) - int64_t(NumInstructions);
+  if (Delta > 0) {
+    NumHackPhisInstructionsAdded += Delta;
+  } else {
+    NumHackPhisInstructionsRemoved += -Delta;
+  }
+
   return Changed;
 }
 
@@ -12,10 +12,14 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <memory>
+
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/UniqueVector.h"
+#include "llvm/Analysis/CFG.h"
+#include "llvm/IR/Dominators.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/Module.h"
@@ -23,10 +27,13 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include "spirv/unified1/spirv.hpp"
+
 #include "clspv/AddressSpace.h"
 #include "clspv/Option.h"
 
 #include "ArgKind.h"
+#include "Builtins.h"
 #include "Passes.h"
 
 using namespace llvm;
@@ -54,7 +61,8 @@ private:
 
   // Attempts to share module scope variables. Returns true if any variables are
   // shared.  Shares variables of the same type that are used by
-  // non-intersecting sets of kernels.
+  // non-intersecting sets of kernels, or by the same kernel on either side of
+  // a work-group barrier.
   bool ShareModuleScopeVariables(Module &M);
 
   // Collects the entry points that can reach |value| into |user_entry_points|.
@@ -66,7 +74,23 @@ private:
   bool HasSharedEntryPoints(const DenseSet<Function *> &user_functions,
                             const UniqueVector<Function *> &other_entry_points);
 
+  // Collects the instructions accessing memory through |value| into |uses|.
+  // Returns false if |value| escapes or is used outside of |*function|. If
+  // |*function| is null, it is set to the first function using |value|.
+  bool CollectUses(Value *value, Function **function,
+                   SmallVectorImpl<Instruction *> *uses);
+
+  // Returns true if a work-group barrier in the kernel using |first| and
+  // |second| separates all the uses of one from all the uses of the other.
+  bool AreSeparatedByBarrier(GlobalVariable *first, GlobalVariable *second);
+
+  // Returns true if all |before| execute before |barrier| and all |after|
+  // execute after it.
+  bool IsSeparatedBy(Instruction *barrier, ArrayRef<Instruction *> before,
+                     ArrayRef<Instruction *> after, const DominatorTree &DT);
+
   EntryPointMap function_to_entry_points_;
+  DenseMap<Function *, std::unique_ptr<DominatorTree>> dominator_trees_;
 };
 
 } // namespace
@@ -91,6 +115,9 @@ bool ShareModuleScopeVariablesPass::runOnModule(Module &M) {
     Changed = ShareModuleScopeVariables(M);
   }
 
+  // The dominator trees would be stale on the next module.
+  dominator_trees_.clear();
+
   return Changed;
 }
 
@@ -158,7 +185,9 @@ bool ShareModuleScopeVariablesPass::ShareModuleScopeVariables(Module &M) {
         continue;
 
       auto &other_entry_points = global_entry_points[&*next];
-      if (!HasSharedEntryPoints(user_functions, other_entry_points)) {
+      if (!HasSharedEntryPoints(user_functions, other_entry_points) ||
+          (clspv::Option::ShareLocalsAcrossBarriers() &&
+           AreSeparatedByBarrier(&*global, &*next))) {
         if (ShowSMSV) {
           outs() << "SMSV: Combining module scope variables\n"
                  << "  " << *global << "\n"
@@ -204,6 +233,97 @@ void ShareModuleScopeVariablesPass::CollectUserEntryPoints(
   }
 }
 
+bool ShareModuleScopeVariablesPass::CollectUses(
+    Value *value, Function **function, SmallVectorImpl<Instruction *> *uses) {
+  for (auto user : value->users()) {
+    auto I = dyn_cast<Instruction>(user);
+    if (!I)
+      return false;
+
+    if (*function && I->getFunction() != *function)
+      return false;
+    *function = I->getFunction();
+
+    if (isa<GetElementPtrInst>(I) || isa<BitCastInst>(I) ||
+        isa<SelectInst>(I)) {
+      if (!CollectUses(I, function, uses))
+        return false;
+    } else if (auto store = dyn_cast<StoreInst>(I)) {
+      // Storing the pointer itself lets it escape.
+      if (store->getValueOperand() == value)
+        return false;
+      uses->push_back(I);
+    } else if (isa<LoadInst>(I) || isa<CallInst>(I) ||
+               isa<AtomicRMWInst>(I) || isa<AtomicCmpXchgInst>(I)) {
+      uses->push_back(I);
+    } else {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool ShareModuleScopeVariablesPass::AreSeparatedByBarrier(
+    GlobalVariable *first, GlobalVariable *second) {
+  Function *function = nullptr;
+  SmallVector<Instruction *, 8> first_uses;
+  SmallVector<Instruction *, 8> second_uses;
+  if (!CollectUses(first, &function, &first_uses) ||
+      !CollectUses(second, &function, &second_uses) || !function ||
+      function->getCallingConv() != CallingConv::SPIR_KERNEL)
+    return false;
+
+  auto &DT = dominator_trees_[function];
+  if (!DT)
+    DT.reset(new DominatorTree(*function));
+
+  for (auto &BB : *function) {
+    for (auto &I : BB) {
+      // Look for work-group barriers ordering Workgroup memory.
+      auto call = dyn_cast<CallInst>(&I);
+      if (!call || !call->getCalledFunction() ||
+          clspv::Builtins::Lookup(call->getCalledFunction()).getType() !=
+              clspv::Builtins::kSpirvOp)
+        continue;
+      auto opcode = dyn_cast<ConstantInt>(call->getArgOperand(0));
+      auto scope = dyn_cast<ConstantInt>(call->getArgOperand(1));
+      if (!opcode || opcode->getZExtValue() != spv::OpControlBarrier ||
+          !scope || scope->getZExtValue() != spv::ScopeWorkgroup)
+        continue;
+      auto semantics = dyn_cast<ConstantInt>(call->getArgOperand(3));
+      if (!semantics || !(semantics->getZExtValue() &
+                          spv::MemorySemanticsWorkgroupMemoryMask))
+        continue;
+
+      if (IsSeparatedBy(call, first_uses, second_uses, *DT) ||
+          IsSeparatedBy(call, second_uses, first_uses, *DT))
+        return true;
+    }
+  }
+
+  return false;
+}
+
+bool ShareModuleScopeVariablesPass::IsSeparatedBy(
+    Instruction *barrier, ArrayRef<Instruction *> before,
+    ArrayRef<Instruction *> after, const DominatorTree &DT) {
+  // Work-group barriers are executed by all the invocations of the
+  // work-group, so none of them accesses |after| before all of them are done
+  // with |before|.
+  for (auto I : before) {
+    if (isPotentiallyReachable(barrier, I, nullptr, &DT))
+      return false;
+  }
+  for (auto I : after) {
+    if (!DT.dominates(barrier, I) ||
+        isPotentiallyReachable(I, barrier, nullptr, &DT))
+      return false;
+  }
+
+  return true;
+}
+
 bool ShareModuleScopeVariablesPass::HasSharedEntryPoints(
     const DenseSet<Function *> &user_functions,
     const UniqueVector<Function *> &other_entry_points) {
@@ -16,6 +16,7 @@
 
 #include "llvm/ADT/APInt.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/IRBuilder.h"
@@ -35,6 +36,11 @@ using namespace llvm;
 
 #define DEBUG_TYPE "signedcomparefixup"
 
+STATISTIC(NumHackSCFInstructionsAdded,
+          "Number of instructions added by -hack-scf");
+STATISTIC(NumHackSCFInstructionsRemoved,
+          "Number of instructions removed by -hack-scf");
+
 namespace {
 
 cl::opt<bool> ShowSCF("show-scf", cl::init(false), cl::Hidden,
@@ -87,6 +93,7 @@ bool SignedCompareFixupPass::runOnModule(Module &M) {
     return Changed;
   }
 
+  const unsigned NumInstructions = M.getInstructionCount();
   SmallVector<Instruction *, 16> to_remove;
   SmallVector<ICmpInst *, 16> work_list;
   for (auto &F : M) {
@@ -250,6 +257,14 @@ bool SignedCompareFixupPass::runOnModule(Module &M) {
     outs() << "\n\nSCF:  DONE\n";
   }
 
+  const int64_t Delta =
+      int64_t(M.getInstructionCount()) - int64_t(NumInstructions);
+  if (Delta > 0) {
+    NumHackSCFInstructionsAdded += Delta;
+  } else {
+    NumHackSCFInstructionsRemoved += -Delta;
+  }
+
   return Changed;
 }
 
@@ -0,0 +1,310 @@
+// Copyright 2021 The Clspv Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <map>
+
+#include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+
+#include "Builtins.h"
+#include "Passes.h"
+
+using namespace llvm;
+
+#define DEBUG_TYPE "vectorizestoragebufferaccesses"
+
+namespace {
+struct VectorizeStorageBufferAccessesPass : public ModulePass {
+  static char ID;
+  VectorizeStorageBufferAccessesPass() : ModulePass(ID) {}
+
+  bool runOnModule(Module &M) override;
+
+private:
+  // The component accesses seen so far for one vector element, in program
+  // order.
+  struct Group {
+    // The first GEP seen. Provides the base and leading indices of the vector
+    // element.
+    GetElementPtrInst *gep = nullptr;
+    SmallVector<Instruction *, 4> accesses;
+  };
+  using Key = SmallVector<Value *, 8>;
+  using GroupMap = MapVector<Key, Group, std::map<Key, unsigned>>;
+
+  // Returns the vector type addressed by |gep| minus its last index if |gep|
+  // selects a single component (with a constant index) of a vector element
+  // of a resource variable. Otherwise returns nullptr.
+  FixedVectorType *GetComponentVectorType(GetElementPtrInst *gep);
+
+  // Merges the accesses of every group in |groups| and clears it.
+  bool FlushLoads(GroupMap &groups);
+  bool FlushStores(GroupMap &groups);
+
+  bool runOnBasicBlock(BasicBlock &BB);
+};
+} // namespace
+
+char VectorizeStorageBufferAccessesPass::ID = 0;
+INITIALIZE_PASS(VectorizeStorageBufferAccessesPass,
+                "VectorizeStorageBufferAccesses",
+                "Vectorize Storage Buffer Accesses Pass", false, false)
+
+namespace clspv {
+ModulePass *createVectorizeStorageBufferAccessesPass() {
+  return new VectorizeStorageBufferAccessesPass();
+}
+} // namespace clspv
+
+namespace {
+
+// Returns the key identifying the vector element addressed by |gep|: its base
+// pointer followed by all but its last index.
+SmallVector<Value *, 8> VectorElementKey(GetElementPtrInst *gep) {
+  SmallVector<Value *, 8> key;
+  key.push_back(gep->getPointerOperand());
+  for (unsigned i = 1; i + 1 < gep->getNumOperands(); ++i) {
+    key.push_back(gep->getOperand(i));
+  }
+  return key;
+}
+
+// Returns the component index selected by |gep|.
+uint64_t ComponentIndex(GetElementPtrInst *gep) {
+  return cast<ConstantInt>(gep->getOperand(gep->getNumOperands() - 1))
+      ->getZExtValue();
+}
+
+} // namespace
+
+FixedVectorType *VectorizeStorageBufferAccessesPass::GetComponentVectorType(
+    GetElementPtrInst *gep) {
+  if (gep->getNumIndices() < 2 ||
+      !isa<ConstantInt>(gep->getOperand(gep->getNumOperands() - 1)))
+    return nullptr;
+
+  SmallVector<Value *, 8> indices(gep->idx_begin(), gep->idx_end() - 1);
+  auto *vec_type = dyn_cast_or_null<FixedVectorType>(
+      GetElementPtrInst::getIndexedType(gep->getSourceElementType(), indices));
+  if (!vec_type || vec_type->getNumElements() > 4)
+    return nullptr;
+
+  // Only accesses rooted at a resource variable are considered. Their layout
+  // is fixed by the Offset and ArrayStride decorations of the enclosing
+  // types, which are unchanged since only whole vector elements are accessed.
+  Value *base = gep->getPointerOperand()->stripPointerCasts();
+  while (auto *base_gep = dyn_cast<GetElementPtrInst>(base)) {
+    base = base_gep->getPointerOperand()->stripPointerCasts();
+  }
+  auto *call = dyn_cast<CallInst>(base);
+  if (!call || !call->getCalledFunction())
+    return nullptr;
+  auto &func_info = clspv::Builtins::Lookup(call->getCalledFunction());
+  if (func_info.getType() != clspv::Builtins::kClspvResource)
+    return nullptr;
+
+  return vec_type;
+}
+
+bool VectorizeStorageBufferAccessesPass::FlushLoads(GroupMap &groups) {
+  bool Changed = false;
+  for (auto &entry : groups) {
+    auto &group = entry.second;
+    if (group.accesses.size() < 2)
+      continue;
+
+    // The vector element must be addressable at the first load.
+    auto *first = group.accesses.front();
+    bool dominates = true;
+    for (auto *value : entry.first) {
+      auto *inst = dyn_cast<Instruction>(value);
+      if (inst && inst->getParent() == first->getParent() &&
+          !inst->comesBefore(first)) {
+        dominates = false;
+        break;
+      }
+    }
+    if (!dominates)
+      continue;
+
+    //
+    // Original IR
+    // 1. x_addr = gep base, idx, 0
+    // 2. x = load (float) x_addr
+    // 3. y_addr = gep base, idx, 1
+    // 4. y = load (float) y_addr
+    //
+    // Transformed IR
+    // 1. vec_addr = gep base, idx
+    // 2. vec = load (float2) vec_addr
+    // 3. x = extractelement vec, 0
+    // 4. y = extractelement vec, 1
+    //
+    IRBuilder<> Builder(first);
+    SmallVector<Value *, 8> indices(group.gep->idx_begin(),
+                                    group.gep->idx_end() - 1);
+    auto *vec_ptr =
+        Builder.CreateInBoundsGEP(group.gep->getSourceElementType(),
+                                  group.gep->getPointerOperand(), indices);
+    auto *vec_type = GetComponentVectorType(group.gep);
+    auto *vec = Builder.CreateLoad(vec_type, vec_ptr);
+    // All the components are extracted before any load is removed, since the
+    // builder inserts before the first load.
+    SmallVector<Value *, 4> components;
+    for (auto *access : group.accesses) {
+      auto *gep = cast<GetElementPtrInst>(
+          cast<LoadInst>(access)->getPointerOperand());
+      components.push_back(Builder.CreateExtractElement(
+          vec, Builder.getInt32(ComponentIndex(gep))));
+    }
+    for (unsigned i = 0; i < group.accesses.size(); ++i) {
+      auto *load = cast<LoadInst>(group.accesses[i]);
+      auto *gep = cast<GetElementPtrInst>(load->getPointerOperand());
+      load->replaceAllUsesWith(components[i]);
+      load->eraseFromParent();
+      if (gep->use_empty())
+        gep->eraseFromParent();
+    }
+    Changed = true;
+  }
+  groups.clear();
+  return Changed;
+}
+
+bool VectorizeStorageBufferAccessesPass::FlushStores(GroupMap &groups) {
+  bool Changed = false;
+  for (auto &entry : groups) {
+    auto &group = entry.second;
+    auto *vec_type = GetComponentVectorType(group.gep);
+
+    // Stores are only merged if every component is written, otherwise the
+    // untouched components would be clobbered.
+    SmallVector<Value *, 4> components(vec_type->getNumElements(), nullptr);
+    bool complete = group.accesses.size() == vec_type->getNumElements();
+    for (auto *access : group.accesses) {
+      auto *store = cast<StoreInst>(access);
+      auto index =
+          ComponentIndex(cast<GetElementPtrInst>(store->getPointerOperand()));
+      if (index >= components.size() || components[index]) {
+        complete = false;
+        break;
+      }
+      components[index] = store->getValueOperand();
+    }
+    if (!complete)
+      continue;
+
+    //
+    // Original IR
+    // 1. x_addr = gep base, idx, 0
+    // 2. store (float) x, x_addr
+    // 3. y_addr = gep base, idx, 1
+    // 4. store (float) y, y_addr
+    //
+    // Transformed IR
+    // 1. vec = insertelement undef, x, 0
+    // 2. vec = insertelement vec, y, 1
+    // 3. vec_addr = gep base, idx
+    // 4. store (float2) vec, vec_addr
+    //
+    // The vector is stored at the last store, where all the values and the
+    // address are available.
+    IRBuilder<> Builder(group.accesses.back());
+    Value *vec = UndefValue::get(vec_type);
+    for (unsigned i = 0; i < components.size(); ++i) {
+      vec = Builder.CreateInsertElement(vec, components[i],
+                                        Builder.getInt32(i));
+    }
+    SmallVector<Value *, 8> indices(group.gep->idx_begin(),
+                                    group.gep->idx_end() - 1);
+    auto *vec_ptr =
+        Builder.CreateInBoundsGEP(group.gep->getSourceElementType(),
+                                  group.gep->getPointerOperand(), indices);
+    Builder.CreateStore(vec, vec_ptr);
+    for (auto *access : group.accesses) {
+      auto *store = cast<StoreInst>(access);
+      auto *gep = cast<GetElementPtrInst>(store->getPointerOperand());
+      store->eraseFromParent();
+      if (gep->use_empty())
+        gep->eraseFromParent();
+    }
+    Changed = true;
+  }
+  groups.clear();
+  return Changed;
+}
+
+bool VectorizeStorageBufferAccessesPass::runOnBasicBlock(BasicBlock &BB) {
+  bool Changed = false;
+
+  // Loads are grouped until something may write memory. Stores are grouped
+  // until something else may read or write memory. Only one vector element is
+  // tracked for stores at a time: merging sinks the earlier stores to the
+  // last one, which must not reorder them with stores to other, possibly
+  // aliasing, elements.
+  GroupMap loads;
+  GroupMap stores;
+  SmallVector<Instruction *, 16> insts;
+  for (auto &I : BB) {
+    insts.push_back(&I);
+  }
+  for (auto *I : insts) {
+    if (auto *load = dyn_cast<LoadInst>(I)) {
+      Changed |= FlushStores(stores);
+      auto *gep = dyn_cast<GetElementPtrInst>(load->getPointerOperand());
+      if (load->isSimple() && gep && GetComponentVectorType(gep)) {
+        auto &group = loads[VectorElementKey(gep)];
+        if (!group.gep)
+          group.gep = gep;
+        group.accesses.push_back(load);
+      }
+    } else if (auto *store = dyn_cast<StoreInst>(I)) {
+      Changed |= FlushLoads(loads);
+      auto *gep = dyn_cast<GetElementPtrInst>(store->getPointerOperand());
+      if (store->isSimple() && gep && GetComponentVectorType(gep)) {
+        auto key = VectorElementKey(gep);
+        if (!stores.empty() && stores.begin()->first != key)
+          Changed |= FlushStores(stores);
+        auto &group = stores[key];
+        if (!group.gep)
+          group.gep = gep;
+        group.accesses.push_back(store);
+      } else {
+        Changed |= FlushStores(stores);
+      }
+    } else if (I->mayReadOrWriteMemory()) {
+      Changed |= FlushStores(stores);
+      if (I->mayWriteToMemory())
+        Changed |= FlushLoads(loads);
+    }
+  }
+  Changed |= FlushLoads(loads);
+  Changed |= FlushStores(stores);
+
+  return Changed;
+}
+
+bool VectorizeStorageBufferAccessesPass::runOnModule(Module &M) {
+  bool Changed = false;
+  for (auto &F : M) {
+    for (auto &BB : F) {
+      Changed |= runOnBasicBlock(BB);
+    }
+  }
+  return Changed;
+}
@@ -0,0 +1,23 @@
+; RUN: clspv-opt -ReplaceOpenCLBuiltin -float-atomics %s -o %t.ll
+; RUN: FileCheck %s < %t.ll
+
+target datalayout = "e-p:32:32-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024"
+target triple = "spir-unknown-unknown"
+
+define void @global(float addrspace(1)* %atomic) {
+entry:
+  %cast = addrspacecast float addrspace(1)* %atomic to float addrspace(4)*
+  %add = call spir_func float @_Z16atomic_fetch_addPU3AS4VU7_Atomicff(float addrspace(4)* %cast, float 1.0)
+  %min = call spir_func float @_Z16atomic_fetch_minPU3AS4VU7_Atomicff(float addrspace(4)* %cast, float 2.0)
+  %max = call spir_func float @_Z16atomic_fetch_maxPU3AS4VU7_Atomicff(float addrspace(4)* %cast, float 3.0)
+  ret void
+}
+
+; CHECK-LABEL: global
+; CHECK: call float @_Z8spirv.op.6035.{{.*}}(i32 6035, float addrspace(1)* %atomic, i32 1, i32 72, float 1.000000e+00)
+; CHECK: call float @_Z8spirv.op.5614.{{.*}}(i32 5614, float addrspace(1)* %atomic, i32 1, i32 72, float 2.000000e+00)
+; CHECK: call float @_Z8spirv.op.5615.{{.*}}(i32 5615, float addrspace(1)* %atomic, i32 1, i32 72, float 3.000000e+00)
+
+declare spir_func float @_Z16atomic_fetch_addPU3AS4VU7_Atomicff(float addrspace(4)*, float)
+declare spir_func float @_Z16atomic_fetch_minPU3AS4VU7_Atomicff(float addrspace(4)*, float)
+declare spir_func float @_Z16atomic_fetch_maxPU3AS4VU7_Atomicff(float addrspace(4)*, float)
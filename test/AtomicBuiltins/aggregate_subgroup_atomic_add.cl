@@ -0,0 +1,25 @@
+// RUN: clspv %s -spv-version=1.3 -aggregate-subgroup-atomics -o %t.spv
+// RUN: spirv-dis -o %t2.spvasm %t.spv
+// RUN: FileCheck %s < %t2.spvasm
+// RUN: spirv-val --target-env vulkan1.1 %t.spv
+
+// The counter address is uniform, so a single invocation per subgroup adds
+// the subgroup total and the others derive their result from it.
+
+// CHECK-DAG: %[[uint:[0-9a-zA-Z_]+]] = OpTypeInt 32 0
+// CHECK-DAG: %[[bool:[0-9a-zA-Z_]+]] = OpTypeBool
+// CHECK-DAG: %[[uint_3:[0-9a-zA-Z_]+]] = OpConstant %[[uint]] 3
+// CHECK:     %[[total:[0-9]+]] = OpGroupNonUniformIAdd %[[uint]] %[[uint_3]] Reduce %[[value:[0-9]+]]
+// CHECK:     %[[offset:[0-9]+]] = OpGroupNonUniformIAdd %[[uint]] %[[uint_3]] ExclusiveScan %[[value]]
+// CHECK:     %[[elect:[0-9]+]] = OpGroupNonUniformElect %[[bool]] %[[uint_3]]
+// CHECK:     OpBranchConditional
+// CHECK:     %[[old:[0-9]+]] = OpAtomicIAdd %[[uint]] {{.*}} %[[total]]
+// CHECK:     %[[phi:[0-9]+]] = OpPhi %[[uint]] %[[old]]
+// CHECK:     %[[base:[0-9]+]] = OpGroupNonUniformBroadcastFirst %[[uint]] %[[uint_3]] %[[phi]]
+// CHECK:     OpIAdd %[[uint]] %[[base]] %[[offset]]
+// CHECK-NOT: OpAtomicIAdd
+
+kernel void foo(global uint *counter, global uint *out, global uint *in) {
+  uint i = get_global_id(0);
+  out[i] = atomic_add(counter, in[i]);
+}
@@ -0,0 +1,24 @@
+// RUN: clspv %s -spv-version=1.3 -aggregate-subgroup-atomics -o %t.spv
+// RUN: spirv-dis -o %t2.spvasm %t.spv
+// RUN: FileCheck %s < %t2.spvasm
+// RUN: spirv-val --target-env vulkan1.1 %t.spv
+
+// The first increment targets a uniform address and is aggregated. Its result
+// is unused so no scan or broadcast is needed. The second one targets an
+// address that varies between invocations and is left alone.
+
+// CHECK-DAG: %[[uint:[0-9a-zA-Z_]+]] = OpTypeInt 32 0
+// CHECK-DAG: %[[uint_1:[0-9a-zA-Z_]+]] = OpConstant %[[uint]] 1
+// CHECK-DAG: %[[uint_3:[0-9a-zA-Z_]+]] = OpConstant %[[uint]] 3
+// CHECK-NOT: ExclusiveScan
+// CHECK:     %[[total:[0-9]+]] = OpGroupNonUniformIAdd %[[uint]] %[[uint_3]] Reduce %[[uint_1]]
+// CHECK:     OpGroupNonUniformElect
+// CHECK:     OpAtomicIAdd %[[uint]] {{.*}} %[[total]]
+// CHECK-NOT: OpGroupNonUniformBroadcastFirst
+// CHECK:     OpAtomicIIncrement %[[uint]]
+
+kernel void foo(global uint *counter, global uint *bins, global uint *in) {
+  uint i = get_global_id(0);
+  atomic_inc(counter);
+  atomic_inc(&bins[in[i]]);
+}
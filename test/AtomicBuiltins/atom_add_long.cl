@@ -0,0 +1,20 @@
+// RUN: clspv %s -int64-atomics -o %t.spv
+// RUN: spirv-dis -o %t2.spvasm %t.spv
+// RUN: FileCheck %s < %t2.spvasm
+// RUN: spirv-val --target-env vulkan1.0 %t.spv
+
+// CHECK-DAG: OpCapability Int64Atomics
+// CHECK-DAG: %[[uint:[0-9a-zA-Z_]+]] = OpTypeInt 32 0
+// CHECK-DAG: %[[ulong:[0-9a-zA-Z_]+]] = OpTypeInt 64 0
+// CHECK-DAG: %[[uint_1:[0-9a-zA-Z_]+]] = OpConstant %[[uint]] 1
+// CHECK-DAG: %[[uint_80:[0-9a-zA-Z_]+]] = OpConstant %[[uint]] 80
+// CHECK-DAG: %[[ulong_42:[0-9a-zA-Z_]+]] = OpConstant %[[ulong]] 42
+// CHECK:     %[[add:[0-9]+]] = OpAtomicIAdd %[[ulong]] {{.*}} %[[uint_1]] %[[uint_80]] %[[ulong_42]]
+// CHECK:     OpStore {{.*}} %[[add]]
+
+#pragma OPENCL EXTENSION cl_khr_int64_base_atomics : enable
+
+kernel void __attribute__((reqd_work_group_size(1, 1, 1))) foo(global long* a, global long* b)
+{
+    *a = atom_add(b, 42);
+}
@@ -0,0 +1,30 @@
+// RUN: clspv %s -float-atomics -o %t.spv
+// RUN: spirv-dis -o %t2.spvasm %t.spv
+// RUN: FileCheck %s < %t2.spvasm
+
+// The compare-exchange loop emulating a float atomic addition is replaced by
+// a native float atomic addition.
+
+// CHECK-DAG: OpCapability AtomicFloat32AddEXT
+// CHECK-DAG: OpExtension "SPV_EXT_shader_atomic_float_add"
+// CHECK-DAG: %[[float:[0-9a-zA-Z_]+]] = OpTypeFloat 32
+// CHECK:     OpAtomicFAddEXT %[[float]]
+// CHECK-NOT: OpAtomicCompareExchange
+
+void atomic_add_float(volatile global float *addr, float value) {
+  union {
+    uint u;
+    float f;
+  } expected, next, current;
+  current.f = *addr;
+  do {
+    expected.f = current.f;
+    next.f = expected.f + value;
+    current.u = atomic_cmpxchg((volatile global uint *)addr, expected.u,
+                               next.u);
+  } while (current.u != expected.u);
+}
+
+kernel void foo(global float *sum, global float *in) {
+  atomic_add_float(sum, in[get_global_id(0)]);
+}
@@ -0,0 +1,27 @@
+// RUN: clspv %s -vulkan-memory-model -o %t.spv
+// RUN: spirv-dis -o %t.spvasm %t.spv
+// RUN: FileCheck %s < %t.spvasm
+// RUN: spirv-val --target-env vulkan1.1 %t.spv
+
+// Coherence is expressed on each access to the buffer instead of with a
+// Coherent decoration. The barrier only orders the work-group, so accesses are
+// made available and visible at work-group scope.
+
+kernel void foo(global int* data, global int* out) {
+  int x = data[0];
+  barrier(CLK_GLOBAL_MEM_FENCE);
+  data[1] = x;
+  out[0] = x;
+}
+
+// CHECK-DAG: OpCapability VulkanMemoryModel
+// CHECK-DAG: OpExtension "SPV_KHR_vulkan_memory_model"
+// CHECK: OpMemoryModel Logical Vulkan
+// CHECK-NOT: OpDecorate {{.*}} Coherent
+// CHECK-DAG: [[uint:%[a-zA-Z0-9_]+]] = OpTypeInt 32 0
+// CHECK-DAG: [[uint_2:%[a-zA-Z0-9_]+]] = OpConstant [[uint]] 2
+// CHECK-DAG: [[semantics:%[a-zA-Z0-9_]+]] = OpConstant [[uint]] 24648
+// CHECK: OpLoad [[uint]] {{%[a-zA-Z0-9_]+}} MakePointerVisible|NonPrivatePointer [[uint_2]]
+// CHECK: OpControlBarrier [[uint_2]] [[uint_2]] [[semantics]]
+// CHECK: OpStore {{%[a-zA-Z0-9_]+}} {{%[a-zA-Z0-9_]+}} MakePointerAvailable|NonPrivatePointer [[uint_2]]
+// CHECK: OpStore {{%[a-zA-Z0-9_]+}} {{%[a-zA-Z0-9_]+}} NonPrivatePointer
@@ -0,0 +1,32 @@
+; RUN: clspv-opt %s -o %t.ll -ReplaceLLVMIntrinsics
+; RUN: FileCheck %s < %t.ll
+
+; Copies of more elements than the threshold are lowered to a loop.
+
+target datalayout = "e-p:32:32-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024"
+target triple = "spir-unknown-unknown"
+
+define void @big_copy(float addrspace(1)* %A) {
+entry:
+  %dst = alloca [64 x float], align 4
+  %src_cast = bitcast float addrspace(1)* %A to i8 addrspace(1)*
+  %dst_cast = bitcast [64 x float]* %dst to i8*
+  call void @llvm.memcpy.p0i8.p1i8.i64(i8* align 4 %dst_cast, i8 addrspace(1)* align 4 %src_cast, i64 256, i1 false)
+  ret void
+}
+
+declare void @llvm.memcpy.p0i8.p1i8.i64(i8*, i8 addrspace(1)*, i64, i1)
+
+; CHECK: entry:
+; CHECK: br label %[[loop:[0-9a-zA-Z_.]+]]
+; CHECK: [[loop]]:
+; CHECK: [[i:%[0-9a-zA-Z_.]+]] = phi i32 [ 0, %entry ], [ [[next:%[0-9a-zA-Z_.]+]], %[[loop]] ]
+; CHECK: [[src_gep:%[0-9a-zA-Z_.]+]] = getelementptr inbounds float, float addrspace(1)* %A, i32 [[i]]
+; CHECK: [[dst_gep:%[0-9a-zA-Z_.]+]] = getelementptr [64 x float], [64 x float]* %dst, i32 0, i32 [[i]]
+; CHECK: call void @_Z17spirv.copy_memory(float* [[dst_gep]], float addrspace(1)* [[src_gep]], i32 4, i32 0)
+; CHECK-NOT: copy_memory
+; CHECK: [[next]] = add i32 [[i]], 1
+; CHECK: [[cmp:%[0-9a-zA-Z_.]+]] = icmp ult i32 [[next]], 64
+; CHECK: br i1 [[cmp]], label %[[loop]], label %[[exit:[0-9a-zA-Z_.]+]]
+; CHECK: [[exit]]:
+; CHECK-NEXT: ret void
@@ -0,0 +1,29 @@
+; RUN: clspv-opt %s -o %t.ll -ReplaceLLVMIntrinsics
+; RUN: FileCheck %s < %t.ll
+
+; Copies into struct members cannot use a dynamic index, so they stay
+; unrolled even above the loop threshold.
+
+target datalayout = "e-p:32:32-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024"
+target triple = "spir-unknown-unknown"
+
+%s = type { float, float, float, float, float, float, float, float, float, float, float, float, float, float, float, float, float, float, float, float }
+
+define void @big_struct_copy(float addrspace(1)* %A) {
+entry:
+  %dst = alloca %s, align 4
+  %src_cast = bitcast float addrspace(1)* %A to i8 addrspace(1)*
+  %dst_cast = bitcast %s* %dst to i8*
+  call void @llvm.memcpy.p0i8.p1i8.i64(i8* align 4 %dst_cast, i8 addrspace(1)* align 4 %src_cast, i64 80, i1 false)
+  ret void
+}
+
+declare void @llvm.memcpy.p0i8.p1i8.i64(i8*, i8 addrspace(1)*, i64, i1)
+
+; CHECK-NOT: phi
+; CHECK: [[dst_gep:%[0-9a-zA-Z_.]+]] = getelementptr %s, %s* %dst, i32 0, i32 0
+; CHECK: call void @_Z17spirv.copy_memory(float* [[dst_gep]]
+; CHECK: [[dst_gep:%[0-9a-zA-Z_.]+]] = getelementptr %s, %s* %dst, i32 0, i32 19
+; CHECK: call void @_Z17spirv.copy_memory(float* [[dst_gep]]
+; CHECK-NOT: phi
+; CHECK: ret void
@@ -0,0 +1,28 @@
+; RUN: clspv-opt %s -o %t.ll -ReplaceLLVMIntrinsics
+; RUN: FileCheck %s < %t.ll
+; RUN: clspv-opt %s -o %t2.ll -ReplaceLLVMIntrinsics -mem-intrinsic-loop-threshold=64
+; RUN: FileCheck %s --check-prefix=UNROLL < %t2.ll
+
+target datalayout = "e-p:32:32-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024"
+target triple = "spir-unknown-unknown"
+
+define void @many_null_bytes(float addrspace(1)* %data) {
+entry:
+  %cast = bitcast float addrspace(1)* %data to i8 addrspace(1)*
+  call void @llvm.memset.p1i8.i32(i8 addrspace(1)* %cast, i8 0, i32 128, i1 false)
+  ret void
+}
+
+declare void @llvm.memset.p1i8.i32(i8 addrspace(1)*, i8, i32, i1)
+
+; CHECK-NOT: bitcast
+; CHECK: [[i:%[0-9a-zA-Z_.]+]] = phi i32 [ 0, %entry ], [ [[next:%[0-9a-zA-Z_.]+]], %[[loop:[0-9a-zA-Z_.]+]] ]
+; CHECK: [[gep:%[0-9a-zA-Z_.]+]] = getelementptr float, float addrspace(1)* %data, i32 [[i]]
+; CHECK: store float 0.000000e+00, float addrspace(1)* [[gep]]
+; CHECK-NOT: store
+; CHECK: [[next]] = add i32 [[i]], 1
+; CHECK: [[cmp:%[0-9a-zA-Z_.]+]] = icmp ult i32 [[next]], 32
+; CHECK: br i1 [[cmp]], label %[[loop]]
+
+; UNROLL-NOT: phi
+; UNROLL-COUNT-32: store float 0.000000e+00
@@ -0,0 +1,39 @@
+; RUN: clspv-opt --LongVectorLowering -long-vector-chunks %s -o %t
+; RUN: FileCheck %s < %t
+
+target datalayout = "e-p:32:32-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024"
+target triple = "spir-unknown-unknown"
+
+define spir_func void @add8(<8 x i32> addrspace(1)* %ptr) {
+entry:
+  %a = load <8 x i32>, <8 x i32> addrspace(1)* %ptr, align 32
+  %ptr1 = getelementptr <8 x i32>, <8 x i32> addrspace(1)* %ptr, i32 1
+  %b = load <8 x i32>, <8 x i32> addrspace(1)* %ptr1, align 32
+  %add = add <8 x i32> %a, %b
+  store <8 x i32> %add, <8 x i32> addrspace(1)* %ptr, align 32
+  ret void
+}
+
+; CHECK-LABEL: @add8
+; CHECK: load { <4 x i32>, <4 x i32> }, { <4 x i32>, <4 x i32> } addrspace(1)*
+; CHECK-NOT: add i32
+; CHECK: add <4 x i32>
+; CHECK: add <4 x i32>
+; CHECK-NOT: add i32
+; CHECK-NOT: add <8 x i32>
+; CHECK: store { <4 x i32>, <4 x i32> }
+
+define spir_func <16 x float> @fma16(<16 x float> %a, <16 x float> %b, <16 x float> %c) {
+entry:
+  %fma = call spir_func <16 x float> @_Z3fmaDv16_fS_S_(<16 x float> %a, <16 x float> %b, <16 x float> %c)
+  %max = call spir_func <16 x float> @_Z4fmaxDv16_ff(<16 x float> %fma, float 0.0)
+  ret <16 x float> %max
+}
+
+; CHECK-LABEL: @fma16
+; CHECK-COUNT-4: call spir_func <4 x float> @_Z3fmaDv4_fS_S_(<4 x float> {{.*}}, <4 x float> {{.*}}, <4 x float> {{.*}})
+; CHECK-COUNT-4: call spir_func <4 x float> @_Z4fmaxDv4_ff(<4 x float> {{.*}}, float 0.000000e+00)
+; CHECK-NOT: <16 x float>
+
+declare spir_func <16 x float> @_Z3fmaDv16_fS_S_(<16 x float>, <16 x float>, <16 x float>)
+declare spir_func <16 x float> @_Z4fmaxDv16_ff(<16 x float>, float)
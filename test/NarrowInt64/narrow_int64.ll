@@ -0,0 +1,57 @@
+; RUN: clspv-opt -NarrowInt64 %s -o %t
+; RUN: FileCheck %s < %t
+
+target datalayout = "e-p:32:32-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024"
+target triple = "spir-unknown-unknown"
+
+; The index only uses the low 32 bits of the 64-bit arithmetic.
+; CHECK-LABEL: @index
+; CHECK: [[mul:%[a-zA-Z0-9_.]+]] = mul i32 %x, 3
+; CHECK: [[add:%[a-zA-Z0-9_.]+]] = add i32 [[mul]], %y
+; CHECK: getelementptr i32, i32 addrspace(1)* %out, i32 [[add]]
+; CHECK-NOT: i64
+define spir_kernel void @index(i32 addrspace(1)* %out, i32 %x, i32 %y) {
+entry:
+  %sx = sext i32 %x to i64
+  %zy = zext i32 %y to i64
+  %mul = mul nsw i64 %sx, 3
+  %add = add nsw i64 %mul, %zy
+  %gep = getelementptr i32, i32 addrspace(1)* %out, i64 %add
+  store i32 0, i32 addrspace(1)* %gep
+  ret void
+}
+
+; Comparisons of extended values are done on the original values.
+; CHECK-LABEL: @compare
+; CHECK: icmp ult i32 %x, %y
+; CHECK: icmp ult i32 %x, 8
+; CHECK: [[shl:%[a-zA-Z0-9_.]+]] = shl i32 %x, 8
+; CHECK: trunc i32 [[shl]] to i8
+define spir_kernel void @compare(i32 addrspace(1)* %out, i8 addrspace(1)* %out8, i32 %x, i32 %y) {
+entry:
+  %zx = zext i32 %x to i64
+  %zy = zext i32 %y to i64
+  %cmp = icmp slt i64 %zx, %zy
+  %cmp2 = icmp sgt i64 8, %zx
+  %sel = select i1 %cmp, i32 1, i32 0
+  %sel2 = select i1 %cmp2, i32 1, i32 0
+  %sum = add i32 %sel, %sel2
+  store i32 %sum, i32 addrspace(1)* %out
+  %shl = shl i64 %zx, 8
+  %t = trunc i64 %shl to i8
+  store i8 %t, i8 addrspace(1)* %out8
+  ret void
+}
+
+; The high bits of a right shift are not known.
+; CHECK-LABEL: @shift
+; CHECK: lshr i64
+; CHECK: getelementptr i32, i32 addrspace(1)* %out, i64
+define spir_kernel void @shift(i32 addrspace(1)* %out, i32 %x) {
+entry:
+  %sx = sext i32 %x to i64
+  %shr = lshr i64 %sx, 4
+  %gep = getelementptr i32, i32 addrspace(1)* %out, i64 %shr
+  store i32 0, i32 addrspace(1)* %gep
+  ret void
+}
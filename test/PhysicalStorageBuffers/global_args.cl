@@ -0,0 +1,32 @@
+// RUN: clspv %s -physical-storage-buffers -o %t.spv
+// RUN: spirv-dis %t.spv -o %t.spvasm
+// RUN: FileCheck %s < %t.spvasm
+// RUN: spirv-val --target-env vulkan1.2 %t.spv
+
+// Global pointer arguments are passed as device addresses in push constants
+// instead of being bound to storage buffer descriptors.
+
+kernel void foo(global float *out, global const float *in, float scale) {
+  uint i = get_global_id(0);
+  out[i] = in[i] * scale;
+}
+
+// CHECK-DAG: OpCapability PhysicalStorageBufferAddresses
+// CHECK-DAG: OpExtension "SPV_KHR_physical_storage_buffer"
+// CHECK: OpMemoryModel PhysicalStorageBuffer64 GLSL450
+// CHECK-NOT: OpDecorate {{.*}} DescriptorSet
+// CHECK-DAG: [[uint:%[a-zA-Z0-9_]+]] = OpTypeInt 32 0
+// CHECK-DAG: [[float:%[a-zA-Z0-9_]+]] = OpTypeFloat 32
+// CHECK-DAG: [[uint_0:%[a-zA-Z0-9_]+]] = OpConstant [[uint]] 0
+// CHECK-DAG: [[uint_8:%[a-zA-Z0-9_]+]] = OpConstant [[uint]] 8
+// CHECK-DAG: [[uint_16:%[a-zA-Z0-9_]+]] = OpConstant [[uint]] 16
+// CHECK-DAG: [[ptr:%[a-zA-Z0-9_]+]] = OpTypePointer PhysicalStorageBuffer [[float]]
+// CHECK-DAG: OpExtInst {{.*}} ArgumentPodPushConstant {{.*}} [[uint_0]] [[uint_8]]
+// CHECK-DAG: OpExtInst {{.*}} ArgumentPodPushConstant {{.*}} [[uint_8]] [[uint_8]]
+// CHECK-DAG: OpExtInst {{.*}} ArgumentPodPushConstant {{.*}} [[uint_16]] {{%[a-zA-Z0-9_]+}}
+// CHECK: [[out:%[a-zA-Z0-9_]+]] = OpConvertUToPtr [[ptr]]
+// CHECK: [[in:%[a-zA-Z0-9_]+]] = OpConvertUToPtr [[ptr]]
+// CHECK: [[in_gep:%[a-zA-Z0-9_]+]] = OpPtrAccessChain [[ptr]] [[in]]
+// CHECK: OpLoad [[float]] [[in_gep]] Aligned 4
+// CHECK: [[out_gep:%[a-zA-Z0-9_]+]] = OpPtrAccessChain [[ptr]] [[out]]
+// CHECK: OpStore [[out_gep]] {{%[a-zA-Z0-9_]+}} Aligned 4
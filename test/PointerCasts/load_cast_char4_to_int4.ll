@@ -0,0 +1,28 @@
+; RUN: clspv-opt %s -o %t -ReplacePointerBitcast
+; RUN: FileCheck %s < %t
+
+; Each char4 chunk is reinterpreted as a whole i32 rather than shuffled into
+; vectors wider than four components. Only one load per chunk is issued.
+
+target datalayout = "e-p:32:32-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024"
+target triple = "spir-unknown-unknown"
+
+; CHECK-NOT: shufflevector
+; CHECK: [[shl:%[a-zA-Z0-9_.]+]] = shl i32 %i, 2
+; CHECK-COUNT-4: load <4 x i8>, <4 x i8> addrspace(1)*
+; CHECK-NOT: load
+; CHECK: [[ld0:%[a-zA-Z0-9_.]+]] = bitcast <4 x i8> %src_val to i32
+; CHECK: [[ins0:%[a-zA-Z0-9_.]+]] = insertelement <4 x i32> undef, i32 [[ld0]], i32 0
+; CHECK: [[ins1:%[a-zA-Z0-9_.]+]] = insertelement <4 x i32> [[ins0]], i32 {{.*}}, i32 1
+; CHECK: [[ins2:%[a-zA-Z0-9_.]+]] = insertelement <4 x i32> [[ins1]], i32 {{.*}}, i32 2
+; CHECK: [[ins3:%[a-zA-Z0-9_.]+]] = insertelement <4 x i32> [[ins2]], i32 {{.*}}, i32 3
+; CHECK-NOT: shufflevector
+; CHECK: store <4 x i32> [[ins3]], <4 x i32> addrspace(1)* %b
+define spir_kernel void @foo(<4 x i8> addrspace(1)* %a, <4 x i32> addrspace(1)* %b, i32 %i) {
+entry:
+  %0 = bitcast <4 x i8> addrspace(1)* %a to <4 x i32> addrspace(1)*
+  %arrayidx = getelementptr inbounds <4 x i32>, <4 x i32> addrspace(1)* %0, i32 %i
+  %1 = load <4 x i32>, <4 x i32> addrspace(1)* %arrayidx, align 16
+  store <4 x i32> %1, <4 x i32> addrspace(1)* %b, align 16
+  ret void
+}
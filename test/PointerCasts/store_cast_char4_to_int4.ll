@@ -0,0 +1,24 @@
+; RUN: clspv-opt %s -o %t -ReplacePointerBitcast
+; RUN: FileCheck %s < %t
+
+; The int4 value is split into one i32 per char4 chunk, giving one store per
+; chunk.
+
+target datalayout = "e-p:32:32-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024"
+target triple = "spir-unknown-unknown"
+
+; CHECK: [[shl:%[a-zA-Z0-9_.]+]] = shl i32 %i, 2
+; CHECK: [[ex0:%[a-zA-Z0-9_.]+]] = extractelement <4 x i32> %0, i32 0
+; CHECK: [[val0:%[a-zA-Z0-9_.]+]] = bitcast i32 [[ex0]] to <4 x i8>
+; CHECK: [[gep0:%[a-zA-Z0-9_.]+]] = getelementptr <4 x i8>, <4 x i8> addrspace(1)* %a, i32 [[shl]]
+; CHECK: store <4 x i8> [[val0]], <4 x i8> addrspace(1)* [[gep0]]
+; CHECK-COUNT-3: store <4 x i8>
+; CHECK-NOT: store
+define spir_kernel void @foo(<4 x i8> addrspace(1)* %a, <4 x i32> addrspace(1)* %b, i32 %i) {
+entry:
+  %0 = load <4 x i32>, <4 x i32> addrspace(1)* %b, align 16
+  %1 = bitcast <4 x i8> addrspace(1)* %a to <4 x i32> addrspace(1)*
+  %arrayidx = getelementptr inbounds <4 x i32>, <4 x i32> addrspace(1)* %1, i32 %i
+  store <4 x i32> %0, <4 x i32> addrspace(1)* %arrayidx, align 16
+  ret void
+}
@@ -0,0 +1,51 @@
+; RUN: clspv-opt -PromotePrivateArrays -max-promoted-private-array-size=4 %s -o %t
+; RUN: FileCheck %s < %t
+
+target datalayout = "e-p:32:32-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024"
+target triple = "spir-unknown-unknown"
+
+; CHECK-LABEL: @small
+; CHECK-NOT: alloca [3 x i32]
+; CHECK: [[a0:%[a-zA-Z0-9_.]+]] = alloca i32
+; CHECK: [[a1:%[a-zA-Z0-9_.]+]] = alloca i32
+; CHECK: [[a2:%[a-zA-Z0-9_.]+]] = alloca i32
+; CHECK: store i32 0, i32* [[a0]]
+; CHECK: store i32 0, i32* [[a1]]
+; CHECK: store i32 0, i32* [[a2]]
+; CHECK: [[is0:%[a-zA-Z0-9_.]+]] = icmp eq i32 %i, 0
+; CHECK: [[old0:%[a-zA-Z0-9_.]+]] = load i32, i32* [[a0]]
+; CHECK: [[new0:%[a-zA-Z0-9_.]+]] = select i1 [[is0]], i32 %x, i32 [[old0]]
+; CHECK: store i32 [[new0]], i32* [[a0]]
+; CHECK: store i32 {{%[a-zA-Z0-9_.]+}}, i32* [[a2]]
+; CHECK: [[last:%[a-zA-Z0-9_.]+]] = load i32, i32* [[a2]]
+; CHECK: [[is1:%[a-zA-Z0-9_.]+]] = icmp eq i32 %j, 1
+; CHECK: [[ld1:%[a-zA-Z0-9_.]+]] = load i32, i32* [[a1]]
+; CHECK: [[sel1:%[a-zA-Z0-9_.]+]] = select i1 [[is1]], i32 [[ld1]], i32 [[last]]
+; CHECK: [[is0b:%[a-zA-Z0-9_.]+]] = icmp eq i32 %j, 0
+; CHECK: [[ld0:%[a-zA-Z0-9_.]+]] = load i32, i32* [[a0]]
+; CHECK: [[sel0:%[a-zA-Z0-9_.]+]] = select i1 [[is0b]], i32 [[ld0]], i32 [[sel1]]
+; CHECK: store i32 [[sel0]], i32 addrspace(1)* %out
+define spir_kernel void @small(i32 addrspace(1)* %out, i32 %i, i32 %j, i32 %x) {
+entry:
+  %arr = alloca [3 x i32], align 4
+  store [3 x i32] zeroinitializer, [3 x i32]* %arr
+  %p = getelementptr inbounds [3 x i32], [3 x i32]* %arr, i32 0, i32 %i
+  store i32 %x, i32* %p
+  %q = getelementptr inbounds [3 x i32], [3 x i32]* %arr, i32 0, i32 %j
+  %v = load i32, i32* %q
+  store i32 %v, i32 addrspace(1)* %out
+  ret void
+}
+
+; Arrays larger than the threshold are left alone.
+; CHECK-LABEL: @large
+; CHECK: alloca [8 x i32]
+define spir_kernel void @large(i32 addrspace(1)* %out, i32 %i) {
+entry:
+  %arr = alloca [8 x i32], align 4
+  %p = getelementptr inbounds [8 x i32], [8 x i32]* %arr, i32 0, i32 %i
+  store i32 %i, i32* %p
+  %v = load i32, i32* %p
+  store i32 %v, i32 addrspace(1)* %out
+  ret void
+}
@@ -0,0 +1,25 @@
+// RUN: clspv %s -o %t.spv
+// RUN: spirv-dis -o %t.spvasm %t.spv
+// RUN: FileCheck %s < %t.spvasm
+// RUN: spirv-val --target-env vulkan1.0 %t.spv
+
+// Buffers that are only read are NonWritable and buffers that are only
+// written are NonReadable. Restrict qualified buffers are decorated Restrict.
+
+kernel void foo(global int *restrict out, global const int *restrict in,
+                global int *inout) {
+  uint i = get_global_id(0);
+  out[i] = in[i] + inout[i];
+  inout[i] = 0;
+}
+
+// CHECK-DAG: OpDecorate [[out:%[a-zA-Z0-9_]+]] Binding 0
+// CHECK-DAG: OpDecorate [[in:%[a-zA-Z0-9_]+]] Binding 1
+// CHECK-DAG: OpDecorate [[inout:%[a-zA-Z0-9_]+]] Binding 2
+// CHECK-DAG: OpDecorate [[out]] NonReadable
+// CHECK-DAG: OpDecorate [[out]] Restrict
+// CHECK-DAG: OpDecorate [[in]] NonWritable
+// CHECK-DAG: OpDecorate [[in]] Restrict
+// CHECK-NOT: OpDecorate [[inout]] NonWritable
+// CHECK-NOT: OpDecorate [[inout]] NonReadable
+// CHECK-NOT: OpDecorate [[inout]] Restrict
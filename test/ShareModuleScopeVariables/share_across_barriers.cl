@@ -0,0 +1,25 @@
+// RUN: clspv %s -o %t.spv -share-locals-across-barriers
+// RUN: spirv-dis -o %t2.spvasm %t.spv
+// RUN: FileCheck %s < %t2.spvasm
+// RUN: spirv-val --target-env vulkan1.0 %t.spv
+
+// |a| is only used before the second barrier and |b| only after it, so they
+// share a single Workgroup variable.
+
+kernel void foo(global int *in, global int *out) {
+  local int a[64];
+  local int b[64];
+  int lid = get_local_id(0);
+  a[lid] = in[lid];
+  barrier(CLK_LOCAL_MEM_FENCE);
+  int x = a[63 - lid];
+  barrier(CLK_LOCAL_MEM_FENCE);
+  b[lid] = x * 2;
+  barrier(CLK_LOCAL_MEM_FENCE);
+  out[lid] = b[63 - lid];
+}
+
+// CHECK-NOT: OpVariable {{.*}} Workgroup
+// CHECK: OpVariable {{.*}} Workgroup
+// CHECK-NOT: OpVariable {{.*}} Workgroup
+// CHECK: OpFunction
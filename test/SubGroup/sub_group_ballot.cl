@@ -0,0 +1,36 @@
+// RUN: clspv %s -cl-std=CL2.0 -spv-version=1.3 -inline-entry-points -o %t.spv
+// RUN: spirv-dis -o %t2.spvasm %t.spv
+// RUN: FileCheck %s < %t2.spvasm
+// RUN: spirv-val --target-env vulkan1.2 %t.spv
+
+// CHECK-DAG: OpCapability GroupNonUniformBallot
+// CHECK-DAG: %[[BOOL_TYPE_ID:[a-zA-Z0-9_]*]] = OpTypeBool
+// CHECK-DAG: %[[UINT_TYPE_ID:[a-zA-Z0-9_]*]] = OpTypeInt 32 0
+// CHECK-DAG: %[[UINT4_TYPE_ID:[a-zA-Z0-9_]*]] = OpTypeVector %[[UINT_TYPE_ID]] 4
+// CHECK-DAG: %[[UINT_0:[a-zA-Z0-9_]*]] = OpConstant %[[UINT_TYPE_ID]] 0
+// CHECK-DAG: %[[UINT_1:[a-zA-Z0-9_]*]] = OpConstant %[[UINT_TYPE_ID]] 1
+// CHECK-DAG: %[[UINT_3:[a-zA-Z0-9_]*]] = OpConstant %[[UINT_TYPE_ID]] 3
+// CHECK-DAG: OpDecorate %{{[a-zA-Z0-9_]*}} BuiltIn SubgroupLtMask
+
+// The int predicate is converted to bool.
+// CHECK: %[[PRED:[a-zA-Z0-9_]*]] = OpINotEqual %[[BOOL_TYPE_ID]]
+// CHECK: %[[BALLOT:[a-zA-Z0-9_]*]] = OpGroupNonUniformBallot %[[UINT4_TYPE_ID]] %[[UINT_3]] %[[PRED]]
+// CHECK: OpGroupNonUniformBallotBitCount %[[UINT_TYPE_ID]] %[[UINT_3]] Reduce %[[BALLOT]]
+// CHECK: OpGroupNonUniformBallotBitCount %[[UINT_TYPE_ID]] %[[UINT_3]] ExclusiveScan %[[BALLOT]]
+// CHECK: OpGroupNonUniformBallotFindLSB %[[UINT_TYPE_ID]] %[[UINT_3]] %[[BALLOT]]
+// CHECK: %[[MASK:[a-zA-Z0-9_]*]] = OpLoad %[[UINT4_TYPE_ID]]
+// CHECK: %[[EXTRACT:[a-zA-Z0-9_]*]] = OpGroupNonUniformBallotBitExtract %[[BOOL_TYPE_ID]] %[[UINT_3]] %[[MASK]]
+// CHECK: OpSelect %[[UINT_TYPE_ID]] %[[EXTRACT]] %[[UINT_1]] %[[UINT_0]]
+// CHECK: OpGroupNonUniformBroadcastFirst %[[UINT_TYPE_ID]] %[[UINT_3]]
+
+#pragma OPENCL EXTENSION cl_khr_subgroups : enable
+
+kernel void test(global uint *a, global uint *b) {
+  uint i = get_global_id(0);
+  uint4 ballot = sub_group_ballot(a[i] > 7);
+  b[5 * i] = sub_group_ballot_bit_count(ballot);
+  b[5 * i + 1] = sub_group_ballot_exclusive_scan(ballot);
+  b[5 * i + 2] = sub_group_ballot_find_lsb(ballot);
+  b[5 * i + 3] = sub_group_ballot_bit_extract(get_sub_group_lt_mask(), 2);
+  b[5 * i + 4] = sub_group_broadcast_first(a[i]);
+}
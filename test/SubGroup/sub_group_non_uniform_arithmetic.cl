@@ -0,0 +1,31 @@
+// RUN: clspv %s -cl-std=CL2.0 -spv-version=1.3 -inline-entry-points -o %t.spv
+// RUN: spirv-dis -o %t2.spvasm %t.spv
+// RUN: FileCheck %s < %t2.spvasm
+// RUN: spirv-val --target-env vulkan1.2 %t.spv
+
+// CHECK-DAG: OpCapability GroupNonUniformArithmetic
+// CHECK-DAG: OpCapability GroupNonUniformClustered
+// CHECK-DAG: %[[BOOL_TYPE_ID:[a-zA-Z0-9_]*]] = OpTypeBool
+// CHECK-DAG: %[[UINT_TYPE_ID:[a-zA-Z0-9_]*]] = OpTypeInt 32 0
+// CHECK-DAG: %[[UINT_3:[a-zA-Z0-9_]*]] = OpConstant %[[UINT_TYPE_ID]] 3
+// CHECK-DAG: %[[UINT_4:[a-zA-Z0-9_]*]] = OpConstant %[[UINT_TYPE_ID]] 4
+
+// CHECK: OpGroupNonUniformIMul %[[UINT_TYPE_ID]] %[[UINT_3]] Reduce %[[X:[a-zA-Z0-9_]*]]
+// CHECK: OpGroupNonUniformBitwiseXor %[[UINT_TYPE_ID]] %[[UINT_3]] InclusiveScan %[[X]]
+// CHECK: OpGroupNonUniformSMin %[[UINT_TYPE_ID]] %[[UINT_3]] ExclusiveScan
+// CHECK: %[[PRED:[a-zA-Z0-9_]*]] = OpINotEqual %[[BOOL_TYPE_ID]]
+// CHECK: %[[AND:[a-zA-Z0-9_]*]] = OpGroupNonUniformLogicalAnd %[[BOOL_TYPE_ID]] %[[UINT_3]] Reduce %[[PRED]]
+// CHECK: OpSelect %[[UINT_TYPE_ID]] %[[AND]]
+// CHECK: OpGroupNonUniformIAdd %[[UINT_TYPE_ID]] %[[UINT_3]] ClusteredReduce %[[X]] %[[UINT_4]]
+
+#pragma OPENCL EXTENSION cl_khr_subgroups : enable
+
+kernel void test(global uint *a, global uint *b, global int *c) {
+  uint i = get_global_id(0);
+  uint x = a[i];
+  b[3 * i] = sub_group_non_uniform_reduce_mul(x);
+  b[3 * i + 1] = sub_group_non_uniform_scan_inclusive_xor(x);
+  c[2 * i] = sub_group_non_uniform_scan_exclusive_min((int)x - 3);
+  c[2 * i + 1] = sub_group_non_uniform_reduce_logical_and((int)x);
+  b[3 * i + 2] = sub_group_clustered_reduce_add(x, 4);
+}
@@ -0,0 +1,26 @@
+// RUN: clspv %s -cl-std=CL2.0 -spv-version=1.3 -inline-entry-points -o %t.spv
+// RUN: spirv-dis -o %t2.spvasm %t.spv
+// RUN: FileCheck %s < %t2.spvasm
+// RUN: spirv-val --target-env vulkan1.2 %t.spv
+
+// CHECK-DAG: OpCapability GroupNonUniformShuffle
+// CHECK-DAG: OpCapability GroupNonUniformShuffleRelative
+// CHECK-DAG: %[[FLOAT_TYPE_ID:[a-zA-Z0-9_]*]] = OpTypeFloat 32
+// CHECK-DAG: %[[UINT_TYPE_ID:[a-zA-Z0-9_]*]] = OpTypeInt 32 0
+// CHECK-DAG: %[[UINT_3:[a-zA-Z0-9_]*]] = OpConstant %[[UINT_TYPE_ID]] 3
+
+// CHECK: OpGroupNonUniformShuffle %[[FLOAT_TYPE_ID]] %[[UINT_3]] %[[X:[a-zA-Z0-9_]*]] %[[ID:[a-zA-Z0-9_]*]]
+// CHECK: OpGroupNonUniformShuffleXor %[[FLOAT_TYPE_ID]] %[[UINT_3]] %[[X]] %[[ID]]
+// CHECK: OpGroupNonUniformShuffleUp %[[FLOAT_TYPE_ID]] %[[UINT_3]] %[[X]] %[[ID]]
+// CHECK: OpGroupNonUniformShuffleDown %[[FLOAT_TYPE_ID]] %[[UINT_3]] %[[X]] %[[ID]]
+
+#pragma OPENCL EXTENSION cl_khr_subgroups : enable
+
+kernel void test(global float *a, global float *b, uint id) {
+  uint i = get_global_id(0);
+  float x = a[i];
+  b[4 * i] = sub_group_shuffle(x, id);
+  b[4 * i + 1] = sub_group_shuffle_xor(x, id);
+  b[4 * i + 2] = sub_group_shuffle_up(x, id);
+  b[4 * i + 3] = sub_group_shuffle_down(x, id);
+}
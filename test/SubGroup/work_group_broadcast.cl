@@ -0,0 +1,28 @@
+// RUN: clspv %s -cl-std=CL2.0 -spv-version=1.3 -inline-entry-points -o %t.spv
+// RUN: spirv-dis -o %t2.spvasm %t.spv
+// RUN: FileCheck %s < %t2.spvasm
+// RUN: spirv-val --target-env vulkan1.2 %t.spv
+
+// The work-item at the requested local id publishes its value through the
+// Workgroup scratch array.
+
+// CHECK-DAG: %[[FLOAT_TYPE_ID:[a-zA-Z0-9_]*]] = OpTypeFloat 32
+// CHECK-DAG: %[[UINT_TYPE_ID:[a-zA-Z0-9_]*]] = OpTypeInt 32 0
+// CHECK-DAG: %[[UINT_2:[a-zA-Z0-9_]*]] = OpConstant %[[UINT_TYPE_ID]] 2
+// CHECK-DAG: %[[UINT_264:[a-zA-Z0-9_]*]] = OpConstant %[[UINT_TYPE_ID]] 264
+// CHECK-DAG: %[[SCRATCH_TYPE:[a-zA-Z0-9_]*]] = OpTypeArray %[[FLOAT_TYPE_ID]]
+// CHECK-DAG: %[[SCRATCH_PTR:[a-zA-Z0-9_]*]] = OpTypePointer Workgroup %[[SCRATCH_TYPE]]
+// CHECK-DAG: %[[SCRATCH:[a-zA-Z0-9_]*]] = OpVariable %[[SCRATCH_PTR]] Workgroup
+// CHECK-DAG: OpDecorate %{{[a-zA-Z0-9_]*}} BuiltIn LocalInvocationId
+// CHECK: OpLogicalAnd
+// CHECK: OpBranchConditional
+// CHECK: OpStore
+// CHECK: OpControlBarrier %[[UINT_2]] %[[UINT_2]] %[[UINT_264]]
+// CHECK: OpAccessChain
+// CHECK: OpLoad %[[FLOAT_TYPE_ID]]
+// CHECK: OpControlBarrier %[[UINT_2]] %[[UINT_2]] %[[UINT_264]]
+
+kernel void test(global float *a, global float *b) {
+  uint i = get_global_id(0);
+  b[i] = work_group_broadcast(a[i], 3, 1);
+}
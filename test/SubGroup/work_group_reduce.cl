@@ -0,0 +1,40 @@
+// RUN: clspv %s -cl-std=CL2.0 -spv-version=1.3 -inline-entry-points -o %t.spv
+// RUN: spirv-dis -o %t2.spvasm %t.spv
+// RUN: FileCheck %s < %t2.spvasm
+// RUN: spirv-val --target-env vulkan1.2 %t.spv
+
+// The sub-group totals are combined through a Workgroup scratch array between
+// two work-group barriers.
+
+// CHECK-DAG: %[[UINT_TYPE_ID:[a-zA-Z0-9_]*]] = OpTypeInt 32 0
+// CHECK-DAG: %[[UINT_2:[a-zA-Z0-9_]*]] = OpConstant %[[UINT_TYPE_ID]] 2
+// CHECK-DAG: %[[UINT_3:[a-zA-Z0-9_]*]] = OpConstant %[[UINT_TYPE_ID]] 3
+// CHECK-DAG: %[[UINT_264:[a-zA-Z0-9_]*]] = OpConstant %[[UINT_TYPE_ID]] 264
+// CHECK-DAG: %[[UINT_128:[a-zA-Z0-9_]*]] = OpConstant %[[UINT_TYPE_ID]] 128
+// CHECK-DAG: %[[SCRATCH_TYPE:[a-zA-Z0-9_]*]] = OpTypeArray %[[UINT_TYPE_ID]] %[[UINT_128]]
+// CHECK-DAG: %[[SCRATCH_PTR:[a-zA-Z0-9_]*]] = OpTypePointer Workgroup %[[SCRATCH_TYPE]]
+// CHECK-DAG: %[[SCRATCH:[a-zA-Z0-9_]*]] = OpVariable %[[SCRATCH_PTR]] Workgroup
+// CHECK-DAG: OpDecorate %{{[a-zA-Z0-9_]*}} BuiltIn SubgroupId
+// CHECK-DAG: OpDecorate %{{[a-zA-Z0-9_]*}} BuiltIn NumSubgroups
+
+// CHECK: OpGroupNonUniformIAdd %[[UINT_TYPE_ID]] %[[UINT_3]] Reduce
+// CHECK: OpControlBarrier %[[UINT_2]] %[[UINT_2]] %[[UINT_264]]
+// CHECK: OpLoopMerge
+// CHECK: OpIAdd %[[UINT_TYPE_ID]]
+// CHECK: OpControlBarrier %[[UINT_2]] %[[UINT_2]] %[[UINT_264]]
+
+// CHECK: OpGroupNonUniformSMin %[[UINT_TYPE_ID]] %[[UINT_3]] Reduce
+// CHECK: OpControlBarrier %[[UINT_2]] %[[UINT_2]] %[[UINT_264]]
+// CHECK: OpExtInst %[[UINT_TYPE_ID]] %{{[a-zA-Z0-9_]*}} SMin
+// CHECK: OpControlBarrier %[[UINT_2]] %[[UINT_2]] %[[UINT_264]]
+
+// work_group_all is the minimum of the predicates.
+// CHECK: OpGroupNonUniformUMin %[[UINT_TYPE_ID]] %[[UINT_3]] Reduce
+// CHECK: OpExtInst %[[UINT_TYPE_ID]] %{{[a-zA-Z0-9_]*}} UMin
+
+kernel void test(global uint *c, global int *d) {
+  uint i = get_global_id(0);
+  c[0] = work_group_reduce_add(i);
+  d[0] = work_group_reduce_min((int)i - 7);
+  d[1] = work_group_all(i < 64);
+}
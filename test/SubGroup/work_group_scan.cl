@@ -0,0 +1,31 @@
+// RUN: clspv %s -cl-std=CL2.0 -spv-version=1.3 -inline-entry-points -o %t.spv
+// RUN: spirv-dis -o %t2.spvasm %t.spv
+// RUN: FileCheck %s < %t2.spvasm
+// RUN: spirv-val --target-env vulkan1.2 %t.spv
+
+// Each sub-group scans its own values and adds the totals of the preceding
+// sub-groups, which are published with a sub-group reduction.
+
+// CHECK-DAG: %[[FLOAT_TYPE_ID:[a-zA-Z0-9_]*]] = OpTypeFloat 32
+// CHECK-DAG: %[[UINT_TYPE_ID:[a-zA-Z0-9_]*]] = OpTypeInt 32 0
+// CHECK-DAG: %[[UINT_3:[a-zA-Z0-9_]*]] = OpConstant %[[UINT_TYPE_ID]] 3
+
+// CHECK: OpGroupNonUniformFAdd %[[FLOAT_TYPE_ID]] %[[UINT_3]] InclusiveScan
+// CHECK: OpGroupNonUniformFAdd %[[FLOAT_TYPE_ID]] %[[UINT_3]] Reduce
+// CHECK: OpControlBarrier
+// CHECK: OpLoopMerge
+// CHECK: OpFAdd %[[FLOAT_TYPE_ID]]
+// CHECK: OpControlBarrier
+// CHECK: OpFAdd %[[FLOAT_TYPE_ID]]
+// CHECK: OpSelect %[[FLOAT_TYPE_ID]]
+
+// CHECK: OpGroupNonUniformFMax %[[FLOAT_TYPE_ID]] %[[UINT_3]] ExclusiveScan
+// CHECK: OpGroupNonUniformFMax %[[FLOAT_TYPE_ID]] %[[UINT_3]] Reduce
+// CHECK: OpExtInst %[[FLOAT_TYPE_ID]] %{{[a-zA-Z0-9_]*}} NMax
+
+kernel void test(global float *a, global float *b, global float *c) {
+  uint i = get_global_id(0);
+  float x = a[i];
+  b[i] = work_group_scan_inclusive_add(x);
+  c[i] = work_group_scan_exclusive_max(x);
+}
@@ -0,0 +1,23 @@
+// RUN: clspv %s -o %t.spv
+// RUN: spirv-dis %t.spv -o %t.spvasm
+// RUN: FileCheck %s < %t.spvasm
+// RUN: spirv-val --target-env vulkan1.0 %t.spv
+
+// The copy is split across the work-group in a loop, and waiting is a
+// work-group barrier on workgroup memory only since the copy writes to local
+// memory.
+
+// CHECK-DAG: [[uint:%[a-zA-Z0-9_]+]] = OpTypeInt 32 0
+// CHECK-DAG: [[uint_2:%[a-zA-Z0-9_]+]] = OpConstant [[uint]] 2
+// CHECK-DAG: [[uint_264:%[a-zA-Z0-9_]+]] = OpConstant [[uint]] 264
+// CHECK-DAG: OpDecorate {{.*}} BuiltIn LocalInvocationId
+// CHECK: OpLoopMerge
+// CHECK: OpLoad
+// CHECK: OpStore
+// CHECK: OpControlBarrier [[uint_2]] [[uint_2]] [[uint_264]]
+// CHECK-NOT: OpFunctionCall
+kernel void foo(global float4 *in, global float4 *out, local float4 *tile, uint n) {
+  event_t e = async_work_group_copy(tile, in, n, 0);
+  wait_group_events(1, &e);
+  out[get_global_id(0)] = tile[get_local_id(0)];
+}
@@ -0,0 +1,21 @@
+// RUN: clspv %s -o %t.spv
+// RUN: spirv-dis %t.spv -o %t.spvasm
+// RUN: FileCheck %s < %t.spvasm
+// RUN: spirv-val --target-env vulkan1.0 %t.spv
+
+// The copy writes to global memory so waiting must also cover uniform memory.
+// The stride scales the global index.
+
+// CHECK-DAG: [[uint:%[a-zA-Z0-9_]+]] = OpTypeInt 32 0
+// CHECK-DAG: [[uint_2:%[a-zA-Z0-9_]+]] = OpConstant [[uint]] 2
+// CHECK-DAG: [[uint_328:%[a-zA-Z0-9_]+]] = OpConstant [[uint]] 328
+// CHECK: OpLoopMerge
+// CHECK: OpIMul [[uint]]
+// CHECK: OpStore
+// CHECK: OpControlBarrier [[uint_2]] [[uint_2]] [[uint_328]]
+kernel void foo(global int *out, local int *tile, uint n, uint stride) {
+  tile[get_local_id(0)] = get_local_id(0);
+  barrier(CLK_LOCAL_MEM_FENCE);
+  event_t e = async_work_group_strided_copy(out, tile, n, stride, 0);
+  wait_group_events(1, &e);
+}
@@ -0,0 +1,65 @@
+; RUN: clspv-opt -NarrowBarriers %s -o %t
+; RUN: FileCheck %s < %t
+
+target datalayout = "e-p:32:32-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024"
+target triple = "spir-unknown-unknown"
+
+@local = internal addrspace(3) global [64 x i32] undef, align 4
+
+; Only local memory is shared across the barrier.
+; CHECK-LABEL: @narrow
+; CHECK: store i32 %x, i32 addrspace(3)*
+; CHECK-NEXT: call void @_Z8spirv.op.224.{{.*}}(i32 224, i32 2, i32 2, i32 264)
+; CHECK-NEXT: load i32, i32 addrspace(3)*
+define spir_kernel void @narrow(i32 addrspace(1)* %out, i32 %x) {
+entry:
+  %gep = getelementptr [64 x i32], [64 x i32] addrspace(3)* @local, i32 0, i32 0
+  store i32 %x, i32 addrspace(3)* %gep
+  call void @_Z8spirv.op.224.jjj(i32 224, i32 2, i32 2, i32 328)
+  %ld = load i32, i32 addrspace(3)* %gep
+  store i32 %ld, i32 addrspace(1)* %out
+  ret void
+}
+
+; Nothing is accessed after the barrier.
+; CHECK-LABEL: @remove
+; CHECK-NOT: spirv.op.224
+; CHECK: ret void
+define spir_kernel void @remove(i32 addrspace(1)* %out, i32 %x) {
+entry:
+  store i32 %x, i32 addrspace(1)* %out
+  call void @_Z8spirv.op.224.jjj(i32 224, i32 2, i32 2, i32 328)
+  ret void
+}
+
+; Back-to-back barriers are merged.
+; CHECK-LABEL: @merge
+; CHECK: store i32 %x, i32 addrspace(1)*
+; CHECK-NEXT: call void @_Z8spirv.op.224.{{.*}}(i32 224, i32 2, i32 1, i32 72)
+; CHECK-NEXT: load i32, i32 addrspace(1)*
+define spir_kernel void @merge(i32 addrspace(1)* %in, i32 addrspace(1)* %out, i32 %x) {
+entry:
+  store i32 %x, i32 addrspace(1)* %out
+  call void @_Z8spirv.op.224.jjj(i32 224, i32 2, i32 2, i32 328)
+  call void @_Z8spirv.op.225.jj(i32 225, i32 1, i32 72)
+  %ld = load i32, i32 addrspace(1)* %in
+  store i32 %ld, i32 addrspace(3)* getelementptr ([64 x i32], [64 x i32] addrspace(3)* @local, i32 0, i32 0)
+  ret void
+}
+
+; Generic pointers may reach global and local memory.
+; CHECK-LABEL: @generic
+; CHECK: store i32 %x, i32 addrspace(4)* %ptr
+; CHECK-NEXT: call void @_Z8spirv.op.224.{{.*}}(i32 224, i32 2, i32 2, i32 328)
+; CHECK-NEXT: load i32, i32 addrspace(4)* %ptr
+define spir_kernel void @generic(i32 addrspace(4)* %ptr, i32 addrspace(1)* %out, i32 %x) {
+entry:
+  store i32 %x, i32 addrspace(4)* %ptr
+  call void @_Z8spirv.op.224.jjj(i32 224, i32 2, i32 2, i32 328)
+  %ld = load i32, i32 addrspace(4)* %ptr
+  store i32 %ld, i32 addrspace(1)* %out
+  ret void
+}
+
+declare void @_Z8spirv.op.224.jjj(i32, i32, i32, i32)
+declare void @_Z8spirv.op.225.jj(i32, i32, i32)
@@ -0,0 +1,22 @@
+
+; RUN: clspv-opt -ReplaceOpenCLBuiltin %s -o %t
+; RUN: FileCheck %s < %t
+
+; The pointer is a cast of a pointer to float4, so the whole vector is loaded
+; at once.
+
+target datalayout = "e-p:32:32-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024"
+target triple = "spir-unknown-unknown"
+
+define void @foo(<4 x float> addrspace(1)* %in, i32 %offset) {
+entry:
+  %cast = bitcast <4 x float> addrspace(1)* %in to float addrspace(1)*
+  %0 = call spir_func <4 x float> @_Z6vload4Dv4_jPU3AS1f(i32 %offset, float addrspace(1)* %cast)
+  ret void
+}
+
+declare <4 x float> @_Z6vload4Dv4_jPU3AS1f(i32, float addrspace(1)*)
+
+; CHECK: [[gep:%[a-zA-Z0-9_.]+]] = getelementptr <4 x float>, <4 x float> addrspace(1)* %in, i32 %offset
+; CHECK: load <4 x float>, <4 x float> addrspace(1)* [[gep]]
+; CHECK-NOT: load float
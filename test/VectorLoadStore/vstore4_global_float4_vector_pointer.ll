@@ -0,0 +1,22 @@
+
+; RUN: clspv-opt -ReplaceOpenCLBuiltin %s -o %t
+; RUN: FileCheck %s < %t
+
+; The pointer is a cast of a pointer to float4, so the whole vector is stored
+; at once.
+
+target datalayout = "e-p:32:32-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024"
+target triple = "spir-unknown-unknown"
+
+define void @foo(<4 x float> addrspace(1)* %out, <4 x float> %data, i32 %offset) {
+entry:
+  %cast = bitcast <4 x float> addrspace(1)* %out to float addrspace(1)*
+  call spir_func void @_Z7vstore4Dv4_fjPU3AS1f(<4 x float> %data, i32 %offset, float addrspace(1)* %cast)
+  ret void
+}
+
+declare void @_Z7vstore4Dv4_fjPU3AS1f(<4 x float>, i32, float addrspace(1)*)
+
+; CHECK: [[gep:%[a-zA-Z0-9_.]+]] = getelementptr <4 x float>, <4 x float> addrspace(1)* %out, i32 %offset
+; CHECK: store <4 x float> %data, <4 x float> addrspace(1)* [[gep]]
+; CHECK-NOT: store float
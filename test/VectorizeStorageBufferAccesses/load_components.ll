@@ -0,0 +1,67 @@
+; RUN: clspv-opt %s -o %t.ll -VectorizeStorageBufferAccesses
+; RUN: FileCheck %s < %t.ll
+
+; CHECK-LABEL: @foo
+; CHECK: [[gep:%[a-zA-Z0-9_.]+]] = getelementptr inbounds { [0 x <4 x float>] }, { [0 x <4 x float>] } addrspace(1)* %0, i32 0, i32 0, i32 %i
+; CHECK: [[vec:%[a-zA-Z0-9_.]+]] = load <4 x float>, <4 x float> addrspace(1)* [[gep]]
+; CHECK: [[x:%[a-zA-Z0-9_.]+]] = extractelement <4 x float> [[vec]], i32 0
+; CHECK: [[y:%[a-zA-Z0-9_.]+]] = extractelement <4 x float> [[vec]], i32 1
+; CHECK: [[w:%[a-zA-Z0-9_.]+]] = extractelement <4 x float> [[vec]], i32 3
+; CHECK-NOT: load
+; CHECK: fadd float [[x]], [[y]]
+; CHECK: fadd float {{.*}}, [[w]]
+
+; CHECK-LABEL: @reversed
+; CHECK: [[gep:%[a-zA-Z0-9_.]+]] = getelementptr inbounds { [0 x <4 x float>] }, { [0 x <4 x float>] } addrspace(1)* %0, i32 0, i32 0, i32 %i
+; CHECK: [[vec:%[a-zA-Z0-9_.]+]] = load <4 x float>, <4 x float> addrspace(1)* [[gep]]
+; CHECK: [[w:%[a-zA-Z0-9_.]+]] = extractelement <4 x float> [[vec]], i32 3
+; CHECK: [[z:%[a-zA-Z0-9_.]+]] = extractelement <4 x float> [[vec]], i32 2
+; CHECK: [[y:%[a-zA-Z0-9_.]+]] = extractelement <4 x float> [[vec]], i32 1
+; CHECK: [[x:%[a-zA-Z0-9_.]+]] = extractelement <4 x float> [[vec]], i32 0
+; CHECK-NOT: load
+; CHECK: fadd float [[w]], [[z]]
+; CHECK: fadd float {{.*}}, [[y]]
+; CHECK: fadd float {{.*}}, [[x]]
+
+target datalayout = "e-p:32:32-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024"
+target triple = "spir-unknown-unknown"
+
+define spir_kernel void @foo(i32 %i) {
+entry:
+  %0 = call { [0 x <4 x float>] } addrspace(1)* @_Z14clspv.resource.0(i32 0, i32 0, i32 0, i32 0, i32 0, i32 0)
+  %1 = call { [0 x float] } addrspace(1)* @_Z14clspv.resource.1(i32 0, i32 1, i32 0, i32 1, i32 1, i32 0)
+  %x.ptr = getelementptr { [0 x <4 x float>] }, { [0 x <4 x float>] } addrspace(1)* %0, i32 0, i32 0, i32 %i, i32 0
+  %x = load float, float addrspace(1)* %x.ptr
+  %y.ptr = getelementptr { [0 x <4 x float>] }, { [0 x <4 x float>] } addrspace(1)* %0, i32 0, i32 0, i32 %i, i32 1
+  %y = load float, float addrspace(1)* %y.ptr
+  %w.ptr = getelementptr { [0 x <4 x float>] }, { [0 x <4 x float>] } addrspace(1)* %0, i32 0, i32 0, i32 %i, i32 3
+  %w = load float, float addrspace(1)* %w.ptr
+  %add = fadd float %x, %y
+  %add2 = fadd float %add, %w
+  %out = getelementptr { [0 x float] }, { [0 x float] } addrspace(1)* %1, i32 0, i32 0, i32 %i
+  store float %add2, float addrspace(1)* %out
+  ret void
+}
+
+define spir_kernel void @reversed(i32 %i) {
+entry:
+  %0 = call { [0 x <4 x float>] } addrspace(1)* @_Z14clspv.resource.0(i32 0, i32 0, i32 0, i32 0, i32 0, i32 0)
+  %1 = call { [0 x float] } addrspace(1)* @_Z14clspv.resource.1(i32 0, i32 1, i32 0, i32 1, i32 1, i32 0)
+  %w.ptr = getelementptr { [0 x <4 x float>] }, { [0 x <4 x float>] } addrspace(1)* %0, i32 0, i32 0, i32 %i, i32 3
+  %w = load float, float addrspace(1)* %w.ptr
+  %z.ptr = getelementptr { [0 x <4 x float>] }, { [0 x <4 x float>] } addrspace(1)* %0, i32 0, i32 0, i32 %i, i32 2
+  %z = load float, float addrspace(1)* %z.ptr
+  %y.ptr = getelementptr { [0 x <4 x float>] }, { [0 x <4 x float>] } addrspace(1)* %0, i32 0, i32 0, i32 %i, i32 1
+  %y = load float, float addrspace(1)* %y.ptr
+  %x.ptr = getelementptr { [0 x <4 x float>] }, { [0 x <4 x float>] } addrspace(1)* %0, i32 0, i32 0, i32 %i, i32 0
+  %x = load float, float addrspace(1)* %x.ptr
+  %add = fadd float %w, %z
+  %add2 = fadd float %add, %y
+  %add3 = fadd float %add2, %x
+  %out = getelementptr { [0 x float] }, { [0 x float] } addrspace(1)* %1, i32 0, i32 0, i32 %i
+  store float %add3, float addrspace(1)* %out
+  ret void
+}
+
+declare { [0 x <4 x float>] } addrspace(1)* @_Z14clspv.resource.0(i32, i32, i32, i32, i32, i32)
+declare { [0 x float] } addrspace(1)* @_Z14clspv.resource.1(i32, i32, i32, i32, i32, i32)
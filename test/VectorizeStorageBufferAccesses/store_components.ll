@@ -0,0 +1,29 @@
+; RUN: clspv-opt %s -o %t.ll -VectorizeStorageBufferAccesses
+; RUN: FileCheck %s < %t.ll
+
+; All components of %0[%i] are written, so the stores are merged. Only one
+; component of %0[%j] is written, so that store is left alone.
+
+; CHECK: [[ins0:%[a-zA-Z0-9_.]+]] = insertelement <2 x i32> undef, i32 %a, i32 0
+; CHECK: [[ins1:%[a-zA-Z0-9_.]+]] = insertelement <2 x i32> [[ins0]], i32 %b, i32 1
+; CHECK: [[gep:%[a-zA-Z0-9_.]+]] = getelementptr inbounds { [0 x <2 x i32>] }, { [0 x <2 x i32>] } addrspace(1)* %0, i32 0, i32 0, i32 %i
+; CHECK: store <2 x i32> [[ins1]], <2 x i32> addrspace(1)* [[gep]]
+; CHECK: [[gep:%[a-zA-Z0-9_.]+]] = getelementptr { [0 x <2 x i32>] }, { [0 x <2 x i32>] } addrspace(1)* %0, i32 0, i32 0, i32 %j, i32 1
+; CHECK: store i32 %a, i32 addrspace(1)* [[gep]]
+
+target datalayout = "e-p:32:32-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024"
+target triple = "spir-unknown-unknown"
+
+define spir_kernel void @foo(i32 %i, i32 %j, i32 %a, i32 %b) {
+entry:
+  %0 = call { [0 x <2 x i32>] } addrspace(1)* @_Z14clspv.resource.0(i32 0, i32 0, i32 0, i32 0, i32 0, i32 0)
+  %y.ptr = getelementptr { [0 x <2 x i32>] }, { [0 x <2 x i32>] } addrspace(1)* %0, i32 0, i32 0, i32 %i, i32 1
+  store i32 %b, i32 addrspace(1)* %y.ptr
+  %x.ptr = getelementptr { [0 x <2 x i32>] }, { [0 x <2 x i32>] } addrspace(1)* %0, i32 0, i32 0, i32 %i, i32 0
+  store i32 %a, i32 addrspace(1)* %x.ptr
+  %z.ptr = getelementptr { [0 x <2 x i32>] }, { [0 x <2 x i32>] } addrspace(1)* %0, i32 0, i32 0, i32 %j, i32 1
+  store i32 %a, i32 addrspace(1)* %z.ptr
+  ret void
+}
+
+declare { [0 x <2 x i32>] } addrspace(1)* @_Z14clspv.resource.0(i32, i32, i32, i32, i32, i32)
@@ -0,0 +1,39 @@
+; RUN: clspv-opt -DefineOpenCLWorkItemBuiltins -specialize-work-item-builtins %s -o %t
+; RUN: FileCheck %s < %t
+
+target datalayout = "e-p:32:32-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024"
+target triple = "spir-unknown-unknown"
+
+; CHECK-LABEL: define spir_kernel void @foo
+; CHECK-DAG: [[gid0:%[a-zA-Z0-9_.]+]] = call spir_func i32 @_Z13get_global_idj(i32 0)
+; CHECK-DAG: [[gid1:%[a-zA-Z0-9_.]+]] = call spir_func i32 @_Z13get_global_idj(i32 1)
+; CHECK-DAG: [[gid2:%[a-zA-Z0-9_.]+]] = call spir_func i32 @_Z13get_global_idj(i32 2)
+; CHECK: [[is2:%[a-zA-Z0-9_.]+]] = icmp eq i32 %dim, 2
+; CHECK: [[sel2:%[a-zA-Z0-9_.]+]] = select i1 [[is2]], i32 [[gid2]], i32 0
+; CHECK: [[is1:%[a-zA-Z0-9_.]+]] = icmp eq i32 %dim, 1
+; CHECK: [[sel1:%[a-zA-Z0-9_.]+]] = select i1 [[is1]], i32 [[gid1]], i32 [[sel2]]
+; CHECK: [[is0:%[a-zA-Z0-9_.]+]] = icmp eq i32 %dim, 0
+; CHECK: [[sel0:%[a-zA-Z0-9_.]+]] = select i1 [[is0]], i32 [[gid0]], i32 [[sel1]]
+; CHECK: store i32 [[sel0]]
+; CHECK: store i32 [[gid0]]
+; CHECK: store i32 [[gid0]]
+; CHECK: store i32 0
+; CHECK-NOT: call spir_func i32 @_Z13get_global_idj
+; CHECK: ret void
+define spir_kernel void @foo(i32 addrspace(1)* %out, i32 %dim) {
+entry:
+  %a = call spir_func i32 @_Z13get_global_idj(i32 %dim)
+  store i32 %a, i32 addrspace(1)* %out
+  %b = call spir_func i32 @_Z13get_global_idj(i32 0)
+  %gep1 = getelementptr i32, i32 addrspace(1)* %out, i32 1
+  store i32 %b, i32 addrspace(1)* %gep1
+  %c = call spir_func i32 @_Z13get_global_idj(i32 0)
+  %gep2 = getelementptr i32, i32 addrspace(1)* %out, i32 2
+  store i32 %c, i32 addrspace(1)* %gep2
+  %d = call spir_func i32 @_Z13get_global_idj(i32 3)
+  %gep3 = getelementptr i32, i32 addrspace(1)* %out, i32 3
+  store i32 %d, i32 addrspace(1)* %gep3
+  ret void
+}
+
+declare spir_func i32 @_Z13get_global_idj(i32)
@@ -0,0 +1,23 @@
+// RUN: clspv %s -o %t.spv
+// RUN: spirv-dis --raw-id -o %t.spvasm %t.spv
+// RUN: FileCheck %s < %t.spvasm
+// RUN: spirv-val --target-env vulkan1.0 %t.spv
+
+// RUN: clspv %s -o %t2.spv
+// RUN: cmp %t.spv %t2.spv
+
+// IDs are dense and numbered in order of first appearance, so the last
+// reflection instruction defines the highest ID.
+
+// CHECK: ; Bound: [[#BOUND:]]
+// CHECK: %1 = OpExtInstImport
+// CHECK-NOT: %[[#BOUND]] =
+// CHECK: %[[#BOUND-1]] = OpExtInst
+// CHECK-NOT: OpExtInst
+
+kernel void foo(global int *a, int n) {
+  for (int i = 0; i < n; ++i) {
+    if (a[i] > 0)
+      a[i] = i;
+  }
+}
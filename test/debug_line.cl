@@ -0,0 +1,23 @@
+// RUN: clspv %s -o %t.spv -g
+// RUN: spirv-dis -o %t.spvasm %t.spv
+// RUN: FileCheck %s < %t.spvasm
+// RUN: spirv-val --target-env vulkan1.0 %t.spv
+
+// RUN: clspv %s -o %t2.spv
+// RUN: spirv-dis -o %t2.spvasm %t2.spv
+// RUN: FileCheck --check-prefix=NODEBUG %s < %t2.spvasm
+
+// CHECK: [[file:%[a-zA-Z0-9_]+]] = OpString "{{.*}}debug_line.cl"
+// CHECK: OpFunction
+// CHECK: OpLine [[file]] 22 {{[0-9]+}}
+// CHECK: OpStore
+// CHECK: OpFunctionEnd
+
+// NODEBUG-NOT: OpLine
+
+kernel void foo(global int *a, global int *b) {
+  int x = *b;
+  // Keep the load and store on separate lines.
+  x = x * 3;
+  *a = x;
+}
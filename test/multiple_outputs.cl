@@ -0,0 +1,21 @@
+// RUN: clspv %s -o %t.spv -spvinc-out=%t.inc -spvasm-out=%t.spvasm -descriptormap-out=%t.map
+// RUN: spirv-val --target-env vulkan1.0 %t.spv
+// RUN: FileCheck --check-prefix=INC %s < %t.inc
+// RUN: FileCheck --check-prefix=ASM %s < %t.spvasm
+// RUN: FileCheck --check-prefix=MAP %s < %t.map
+
+// The same outputs are produced when the primary output is the C initializer.
+// RUN: clspv %s -mfmt=c -o %t2.inc -spv-out=%t2.spv
+// RUN: cmp %t.spv %t2.spv
+// RUN: cmp %t.inc %t2.inc
+
+// INC: {119734787,
+// INC-NEXT: 65536,
+
+// ASM: OpEntryPoint GLCompute {{.*}} "foo"
+// ASM: OpFunctionEnd
+
+// MAP: kernel,foo,arg,a,argOrdinal,0,descriptorSet,0,binding,0,offset,0,argKind,buffer
+// MAP-NEXT: kernel,foo,arg,b,argOrdinal,1,{{.*}},argKind,pod
+
+kernel void foo(global int *a, int b) { *a = b; }
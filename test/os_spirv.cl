@@ -0,0 +1,27 @@
+// RUN: clspv %s -o %t.spv -Os-spirv
+// RUN: spirv-dis -o %t.spvasm %t.spv
+// RUN: FileCheck %s < %t.spvasm
+// RUN: spirv-val --target-env vulkan1.0 %t.spv
+
+// RUN: clspv %s -o %t2.spv
+// RUN: spirv-dis -o %t2.spvasm %t2.spv
+// RUN: FileCheck --check-prefix=DEFAULT %s < %t2.spvasm
+// RUN: FileCheck --check-prefix=DECORATE %s < %t2.spvasm
+
+// CHECK-NOT: OpSource
+// CHECK: OpString "foo"
+// CHECK: OpDecorate {{.*}} DescriptorSet 0
+
+// DEFAULT: OpSource OpenCL_C 120
+
+// The global and constant buffers share the same runtime array type, which is
+// decorated only once even without -Os-spirv.
+// DECORATE: OpDecorate [[array:%[a-zA-Z0-9_]+]] ArrayStride 16
+// DECORATE-NOT: OpDecorate [[array]] ArrayStride
+// DECORATE: [[array]] = OpTypeRuntimeArray
+
+kernel void foo(global int *a, global int *b) { *a = *b; }
+
+kernel void bar(global int4 *a, constant int4 *b) {
+  a[get_global_id(0)] = b[get_global_id(0)];
+}
@@ -0,0 +1,20 @@
+// RUN: clspv %s -o %t.spv -stream-functions -no-inline-single
+// RUN: spirv-dis -o %t.spvasm %t.spv
+// RUN: FileCheck %s < %t.spvasm
+// RUN: spirv-val --target-env vulkan1.0 %t.spv
+
+// CHECK: OpEntryPoint GLCompute [[foo:%[a-zA-Z0-9_]+]] "foo"
+// CHECK: [[helper:%[a-zA-Z0-9_]+]] = OpFunction
+// CHECK: OpFunctionEnd
+// CHECK: [[foo]] = OpFunction
+// CHECK: OpFunctionCall {{.*}} [[helper]]
+// CHECK: OpFunctionEnd
+// CHECK: OpExtInst {{.*}} Kernel [[foo]]
+
+__attribute__((noinline))
+int helper(global int *a, int i) { return a[i] * 2; }
+
+kernel void foo(global int *a, int n) {
+  for (int i = 0; i < n; ++i)
+    a[i] = helper(a, i);
+}